@@ -0,0 +1,19 @@
+#include "Arena.hpp"
+
+void *Arena::allocate(usz size, usz alignment) {
+    usz padding = -reinterpret_cast<uintptr_t>(m_cursor) & (alignment - 1);
+    if (m_cursor == nullptr or padding + size > m_remaining) {
+        usz chunk_size = std::max(m_next_chunk_size, size + alignment);
+        m_next_chunk_size = std::min(m_next_chunk_size * 2, m_max_chunk_size);
+        m_chunks.push_back(std::make_unique_for_overwrite<char[]>(chunk_size));
+        m_reserved += chunk_size;
+        m_cursor = m_chunks.back().get();
+        m_remaining = chunk_size;
+        padding = -reinterpret_cast<uintptr_t>(m_cursor) & (alignment - 1);
+    }
+    void *memory = m_cursor + padding;
+    m_cursor += padding + size;
+    m_remaining -= padding + size;
+    m_used += size;
+    return memory;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Common.hpp"
+#include <algorithm>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// Hands out memory from chunks that are all freed together when the arena
+// goes away. Chunks start small and double up to `max_chunk_size`, so an
+// arena that only ever holds a few objects stays small. Nothing placed in an
+// arena has its destructor run.
+class Arena {
+  public:
+    explicit Arena(usz first_chunk_size = 4 * 1024, usz max_chunk_size = 256 * 1024)
+            : m_next_chunk_size(first_chunk_size), m_max_chunk_size(max_chunk_size) {}
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(usz size, usz alignment);
+
+    template <typename T, typename... Args> T *make(Args &&...args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+    }
+
+    // Copies `items` into the arena.
+    template <typename T> std::span<T> copy(std::span<const T> items) {
+        static_assert(std::is_trivially_copyable_v<T>, "arena objects are never destroyed");
+        if (items.empty()) return {};
+        T *memory = static_cast<T *>(allocate(items.size_bytes(), alignof(T)));
+        std::copy(items.begin(), items.end(), memory);
+        return std::span<T>(memory, items.size());
+    }
+
+    // Bytes handed out, and bytes reserved in chunks.
+    [[nodiscard]] usz used() const { return m_used; }
+    [[nodiscard]] usz reserved() const { return m_reserved; }
+
+  private:
+    Vec<Unique<char[]>> m_chunks{};
+    char *m_cursor{nullptr};
+    usz m_remaining{0};
+    usz m_used{0}, m_reserved{0};
+    usz m_next_chunk_size, m_max_chunk_size;
+};
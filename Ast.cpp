@@ -3,6 +3,88 @@
 #include "Ast.hpp"
 #include "Common.hpp"
 
+ExprId Ast::push(ExprKind kind, Span span, Node node) {
+    m_expr_kinds.push_back(kind);
+    m_expr_spans.push_back(span);
+    m_expr_data.push_back(node);
+    return m_expr_kinds.size() - 1;
+}
+
+TypeNodeId Ast::add(const Type &type) {
+    Node node{};
+    switch (type.type) {
+        case Type::Kind::Id: node = {type.id.value, 0, 0}; break;
+        case Type::Kind::Generic:
+            node = {type.id.value, append(m_type_lists, type.generic_args), static_cast<u32>(type.generic_args.size())};
+            break;
+        case Type::Kind::Array:
+        case Type::Kind::Weak:
+        case Type::Kind::Raw:
+        case Type::Kind::Optional: node = {0, type.subtype, 0}; break;
+        case Type::Kind::Undetermined:
+        case Type::Kind::Str:
+        case Type::Kind::Int: break;
+    }
+    m_type_kinds.push_back(type.type);
+    m_type_spans.push_back(type.id.span);
+    m_type_data.push_back(node);
+    return m_type_kinds.size() - 1;
+}
+
+Type Ast::type(TypeNodeId id) const {
+    const Node &node = m_type_data[id];
+    Type::Kind kind = m_type_kinds[id];
+    return Type{
+            .type = kind,
+            .id = {node.a, m_type_spans[id]},
+            .subtype = node.b,
+            .generic_args = kind == Type::Kind::Generic
+                    ? Slice<const TypeNodeId>(m_type_lists.data() + node.b, node.c)
+                    : Slice<const TypeNodeId>(),
+    };
+}
+
+Str Ast::type_repr(TypeNodeId id) const {
+    Type type = this->type(id);
+    switch (type.type) {
+        case Type::Kind::Undetermined: return "<?>";
+        case Type::Kind::Id: return Str(interner.text(type.id.value));
+        case Type::Kind::Str: return "str";
+        case Type::Kind::Int: return "int";
+        case Type::Kind::Array: return std::format("[{}]", type_repr(type.subtype));
+        case Type::Kind::Weak: return std::format("weak {}", type_repr(type.subtype));
+        case Type::Kind::Raw: return std::format("raw {}", type_repr(type.subtype));
+        case Type::Kind::Optional: return std::format("{}?", type_repr(type.subtype));
+        case Type::Kind::Generic: {
+            Str repr{interner.text(type.id.value)};
+            repr += "[";
+            for (usz i = 0; i < type.generic_args.size(); ++i) {
+                repr += type_repr(type.generic_args[i]);
+                if (i != type.generic_args.size() - 1) repr += ", ";
+            }
+            repr += "]";
+            return repr;
+        }
+    }
+}
+
+Ast::Stats Ast::stats() const {
+    usz bytes = m_expr_kinds.capacity() * sizeof(ExprKind) + m_expr_spans.capacity() * sizeof(Span) +
+                m_expr_data.capacity() * sizeof(Node) + m_type_kinds.capacity() * sizeof(Type::Kind) +
+                m_type_spans.capacity() * sizeof(Span) + m_type_data.capacity() * sizeof(Node) +
+                m_expr_lists.capacity() * sizeof(ExprId) + m_type_lists.capacity() * sizeof(TypeNodeId) +
+                m_arguments.capacity() * sizeof(Argument) + m_patterns.capacity() * sizeof(Pattern *) +
+                m_strings.capacity() * sizeof(Str) + m_extra.capacity() * sizeof(u32);
+    for (const Str &string : m_strings)
+        if (string.capacity() > Str().capacity()) bytes += string.capacity();
+    return Stats{
+            .expressions = m_expr_kinds.size(),
+            .types = m_type_kinds.size(),
+            .bytes = bytes,
+            .arena = m_arena.stats(),
+    };
+}
+
 static usz indent = 0;
 
 void AstPrinter::print(const Vec<ParsedStatement *>& stmts) {
@@ -12,11 +94,11 @@ void AstPrinter::print(const Vec<ParsedStatement *>& stmts) {
     }
 }
 
-void AstPrinter::field(ParsedField field) {
+void AstPrinter::field(const ParsedField &field) {
     for (usz i = 0; i < indent; i++)
         std::cout << "    ";
 
-    std::cout << type(field.type) << " " << field.id.value;
+    std::cout << type(field.type) << " " << interner.text(field.id.value);
     if (field.value.has_value()) {
         std::cout << " = ";
         expression(field.value.value(), false);
@@ -24,14 +106,14 @@ void AstPrinter::field(ParsedField field) {
     std::cout << "\n";
 }
 
-void AstPrinter::method(ParsedMethod method) {
+void AstPrinter::method(const ParsedMethod &method) {
     for (usz i = 0; i < indent; i++)
         std::cout << "    ";
 
-    std::cout << (method.unsafe ? "unsafe " : "") << "fun " << method.id.value << "(";
+    std::cout << (method.unsafe ? "unsafe " : "") << "fun " << interner.text(method.id.value) << "(";
     for (usz i = 0; i < method.parameters.size(); ++i) {
         auto& param = method.parameters[i];
-        std::cout << type(param.type) << " " << param.id.value;
+        std::cout << type(param.type) << " " << interner.text(param.id.value);
         if (i != method.parameters.size() - 1)
             std::cout << ", ";
     }
@@ -51,133 +133,137 @@ void AstPrinter::statement(ParsedStatement *stmt) {
         std::cout << "    ";
 
     struct Visitor {
+        AstPrinter &printer;
+
         void operator()(const ParsedObject *object) const {
-            std::cout << "object " << object->id.value << "(";
+            std::cout << "object " << interner.text(object->id.value) << "(";
             for (usz i = 0; i < object->interfaces.size(); i++) {
-                std::cout << object->interfaces.at(i).value;
+                std::cout << interner.text(object->interfaces.at(i).value);
                 if (i != object->interfaces.size() - 1)
                     std::cout << ", ";
             }
             std::cout << ")";
             if (object->parent.has_value())
-                std::cout << " > " << object->parent.value().value;
+                std::cout << " > " << interner.text(object->parent.value().value);
             std::cout << "\n";
             indent += 1;
-            for (const auto& f : object->fields) field(f);
-            for (const auto& m : object->methods) method(m);
+            for (const auto& f : object->fields) printer.field(f);
+            for (const auto& m : object->methods) printer.method(m);
             indent -= 1;
         }
 
         void operator()(const ParsedInterface *interface) const {
-            std::cout << "interface " << interface->id.value << "(";
+            std::cout << "interface " << interner.text(interface->id.value) << "(";
             for (usz i = 0; i < interface->interfaces.size(); i++) {
-                std::cout << interface->interfaces.at(i).value;
+                std::cout << interner.text(interface->interfaces.at(i).value);
                 if (i != interface->interfaces.size() - 1)
                     std::cout << ", ";
             }
             std::cout << ")\n";
             indent += 1;
-            for (const auto& m : interface->methods) method(m);
+            for (const auto& m : interface->methods) printer.method(m);
             indent -= 1;
         }
 
         void operator()(const ParsedFunction *fun) const {
-            std::cout << (fun->unsafe ? "unsafe " : "") << "fun " << fun->id.value << "(";
+            std::cout << (fun->unsafe ? "unsafe " : "") << "fun " << interner.text(fun->id.value) << "(";
             for (usz i = 0; i < fun->parameters.size(); ++i) {
                 auto& param = fun->parameters[i];
-                std::cout << type(param.type) << " " << param.id.value;
+                std::cout << printer.type(param.type) << " " << interner.text(param.id.value);
                 if (i != fun->parameters.size() - 1)
                     std::cout << ", ";
             }
             std::cout << ")";
             if (fun->ret_type.has_value())
-                std::cout << " > " << type(fun->ret_type.value());
+                std::cout << " > " << printer.type(fun->ret_type.value());
             std::cout << "\n";
             indent += 1;
             for (auto stmt : fun->body.elems) {
-                statement(stmt);
+                printer.statement(stmt);
             }
             indent -= 1;
         }
 
         void operator()(const ParsedVariable *var) const {
-            std::cout << "var " << type(var->type) << " " << var->id.value << " = ";
-            expression(var->expr, false);
+            std::cout << "var " << printer.type(var->type) << " " << interner.text(var->id.value) << " = ";
+            printer.expression(var->expr, false);
             std::cout << "\n";
         }
 
         void operator()(const ParsedReturn *ret) const {
             std::cout << "return ";
             if (ret->value.has_value())
-                expression(ret->value.value(), false);
+                printer.expression(ret->value.value(), false);
             std::cout << "\n";
         }
 
         void operator()(const ParsedExpression *expr) const {
-            expression(expr->expr, false);
+            printer.expression(expr->expr, false);
             std::cout << "\n";
         }
     };
 
-    std::visit(Visitor{}, stmt->var);
+    std::visit(Visitor{*this}, stmt->var);
 }
 
-void AstPrinter::expression(Expression *expr, bool print_indent) {
+void AstPrinter::expression(ExprId expr, bool print_indent) {
     if (print_indent) for (usz i = 0; i < indent; i++)
         std::cout << "    ";
 
     struct Visitor {
-        void operator()(const ExpressionDetails::Null *) const {
+        AstPrinter &printer;
+
+        void operator()(const ExpressionDetails::Null &) const {
             std::cout << "null";
         }
 
-        void operator()(const ExpressionDetails::Id *id) const {
-            std::cout << id->id.value;
+        void operator()(const ExpressionDetails::Id &id) const {
+            std::cout << interner.text(id.id.value);
         }
 
-        void operator()(const ExpressionDetails::Int *integer) const {
-            std::cout << std::to_string(integer->value.value);
+        void operator()(const ExpressionDetails::Int &integer) const {
+            std::cout << std::to_string(integer.value.value);
         }
 
-        void operator()(const ExpressionDetails::String *string) const {
-            std::cout << string->value.value;
+        void operator()(const ExpressionDetails::String &string) const {
+            std::cout << string.value.value;
         }
 
-        void operator()(const ExpressionDetails::Call *call) const {
-            expression(call->callee, false);
+        void operator()(const ExpressionDetails::Call &call) const {
+            printer.expression(call.callee, false);
             std::cout << "(";
-            for (usz i = 0; i < call->arguments.size(); ++i) {
-                auto& arg = call->arguments[i];
+            for (usz i = 0; i < call.arguments.size(); ++i) {
+                auto& arg = call.arguments[i];
                 if (arg.id.has_value())
-                    std::cout << arg.id.value().value << ": ";
-                expression(arg.expr, false);
-                if (i != call->arguments.size() - 1)
+                    std::cout << interner.text(arg.id.value().value) << ": ";
+                printer.expression(arg.expr, false);
+                if (i != call.arguments.size() - 1)
                     std::cout << ", ";
             }
             std::cout << ")";
         }
 
-        void operator()(const ExpressionDetails::Index *index) const {
-            expression(index->expr, false);
+        void operator()(const ExpressionDetails::Index &index) const {
+            printer.expression(index.expr, false);
             std::cout << "[";
-            expression(index->index, false);
+            printer.expression(index.index, false);
             std::cout << "]";
         }
 
-        void operator()(const ExpressionDetails::GenericInstance *generic) const {
-            expression(generic->expr, false);
+        void operator()(const ExpressionDetails::GenericInstance &generic) const {
+            printer.expression(generic.expr, false);
             std::cout << "[";
-            for (usz i = 0; i < generic->generic_args.size(); ++i) {
-                auto& param = generic->generic_args[i];
-                std::cout << type(param);
-                if (i != generic->generic_args.size() - 1)
+            for (usz i = 0; i < generic.generic_args.size(); ++i) {
+                auto& param = generic.generic_args[i];
+                std::cout << printer.type(param);
+                if (i != generic.generic_args.size() - 1)
                     std::cout << ", ";
             }
             std::cout << "]";
         }
 
-        void operator()(const ExpressionDetails::Unary *unary) const {
-            switch (unary->operation) {
+        void operator()(const ExpressionDetails::Unary &unary) const {
+            switch (unary.operation) {
                 case ExpressionDetails::Unary::Operation::Dereference:
                     std::cout << "*";
                     break;
@@ -185,48 +271,48 @@ void AstPrinter::expression(Expression *expr, bool print_indent) {
                     std::cout << "&";
                     break;
             }
-            expression(unary->value, false);
+            printer.expression(unary.value, false);
         }
 
-        void operator()(const ExpressionDetails::Binary *binary) const {
-            expression(binary->left, false);
-            switch (binary->operation) {
+        void operator()(const ExpressionDetails::Binary &binary) const {
+            printer.expression(binary.left, false);
+            switch (binary.operation) {
                 case ExpressionDetails::Binary::Operation::Equals:
                     std::cout << " == ";
                     break;
             }
-            expression(binary->right, false);
+            printer.expression(binary.right, false);
         }
 
-        void operator()(const ExpressionDetails::If *if_) const {
+        void operator()(const ExpressionDetails::If &if_) const {
             std::cout << "if ";
-            expression(if_->condition, false);
+            printer.expression(if_.condition, false);
             std::cout << " then ";
-            expression(if_->then, false);
+            printer.expression(if_.then, false);
             std::cout << " else ";
-            expression(if_->else_, false);
+            printer.expression(if_.else_, false);
         }
 
-        void operator()(const ExpressionDetails::Access *access) const {
-            expression(access->expr, false);
+        void operator()(const ExpressionDetails::Access &access) const {
+            printer.expression(access.expr, false);
             std::cout << ".";
-            expression(access->member, false);
+            printer.expression(access.member, false);
         }
 
-        void operator()(const ExpressionDetails::Switch *switch_) const {
+        void operator()(const ExpressionDetails::Switch &switch_) const {
         }
 
-        void operator()(const ExpressionDetails::UnsafeBlock *unsafe_block) const {
+        void operator()(const ExpressionDetails::UnsafeBlock &unsafe_block) const {
             std::cout << "unsafe\n";
             indent += 1;
-            for (auto item : unsafe_block->body.elems) {
-                expression(item);
+            for (auto item : unsafe_block.body) {
+                printer.expression(item);
             }
             indent -= 1;
         }
     };
 
-    std::visit(Visitor{}, expr->var);
+    m_ast.visit(expr, Visitor{*this});
 }
 
-Str AstPrinter::type(Type *ty) { return Type::repr(*ty); }
+Str AstPrinter::type(TypeNodeId ty) { return m_ast.type_repr(ty); }
@@ -1,61 +1,81 @@
 #pragma once
 
 #include <format>
+#include <span>
+#include "AstArena.hpp"
 #include "Common.hpp"
+#include "Interner.hpp"
+
+template <typename T> using Slice = std::span<T>;
+
+// Expressions and type names are nodes in the flat tables of an `Ast` and are
+// referred to by index; see `Ast` below.
+using ExprId = u32;
+using TypeNodeId = u32;
 
 struct ParsedStatement;
-struct Expression;
-struct Type;
 struct Pattern;
 
 template <typename T> struct Block { Vec<T> elems; };
 
 struct ParsedField {
-    Type *type;
-    SpannedStr id;
-    Opt<::Expression *> value;
+    TypeNodeId type;
+    SpannedSymbol id;
+    Opt<ExprId> value;
+};
+
+// A body the parser skipped, to be parsed when it is first needed: the
+// source from its `:` on, inside a block indented by `indent`.
+struct DeferredBody {
+    StrView source;
+    FileId file_id;
+    u32 offset;
+    u32 indent;
 };
 
 struct ParsedMethod {
-    SpannedStr id;
+    SpannedSymbol id;
     Vec<ParsedField> parameters;
-    Opt<Type *> ret_type;
+    Opt<TypeNodeId> ret_type;
     Block<ParsedStatement *> body;
     bool unsafe{false};
     bool static_{false};
+    // Set instead of `body` when the parser deferred it.
+    Opt<DeferredBody> deferred{};
 };
 
 struct ParsedObject {
-    SpannedStr id;
-    Vec<Type *> generic_params;
-    Opt<SpannedStr> parent;
-    Vec<SpannedStr> interfaces;
+    SpannedSymbol id;
+    Vec<TypeNodeId> generic_params;
+    Opt<SpannedSymbol> parent;
+    Vec<SpannedSymbol> interfaces;
     Vec<ParsedField> fields;
     Vec<ParsedMethod> methods;
 };
 
 struct ParsedInterface {
-    SpannedStr id;
-    Vec<SpannedStr> interfaces;
+    SpannedSymbol id;
+    Vec<SpannedSymbol> interfaces;
     Vec<ParsedMethod> methods;
 };
 
 struct ParsedVariable {
-    Type *type;
-    SpannedStr id;
-    ::Expression *expr;
+    TypeNodeId type;
+    SpannedSymbol id;
+    ExprId expr;
 };
 
 struct ParsedFunction {
-    SpannedStr id;
+    SpannedSymbol id;
     Vec<ParsedField> parameters;
-    Opt<Type *> ret_type;
+    Opt<TypeNodeId> ret_type;
     Block<ParsedStatement *> body;
     bool unsafe{false};
+    Opt<DeferredBody> deferred{};
 };
 
-struct ParsedReturn { Span span{}; Opt<::Expression *> value; };
-struct ParsedExpression { ::Expression *expr; };
+struct ParsedReturn { Span span{}; Opt<ExprId> value; };
+struct ParsedExpression { ExprId expr; };
 
 struct ParsedStatement {
     enum class Kind { Object, Interface, Fun, Var, Return, Expr };
@@ -70,179 +90,103 @@ struct ParsedStatement {
 };
 
 struct ParsedNamespace {
-    Opt<Str> name;
+    Opt<Symbol> name;
     Vec<ParsedFunction *> functions;
     Vec<ParsedObject *> objects;
     Vec<ParsedNamespace *> namespaces;
 };
 
 struct Argument {
-    Opt<SpannedStr> id;
-    ::Expression *expr;
+    Opt<SpannedSymbol> id;
+    ExprId expr;
+};
+
+#define EXPRESSION_KINDS                                                       \
+    X(Null)                                                                    \
+    X(Id)                                                                      \
+    X(Int)                                                                     \
+    X(String)                                                                  \
+    X(Call)                                                                    \
+    X(Index)                                                                   \
+    X(GenericInstance)                                                         \
+    X(Unary)                                                                   \
+    X(Binary)                                                                  \
+    X(If)                                                                      \
+    X(Access)                                                                  \
+    X(Switch)                                                                  \
+    X(UnsafeBlock)
+
+enum class ExprKind : u8 {
+#define X(kind) kind,
+    EXPRESSION_KINDS
+#undef X
 };
 
+// What `Ast::get()` hands out for each kind of expression, and what the parser
+// passes to `Ast::add()`. Slices point into the tables of the `Ast`.
 namespace ExpressionDetails {
 
     struct Null { Span span;};
-    struct Id { SpannedStr id; };
+    struct Id { SpannedSymbol id; };
     struct Int { Spanned<int> value; };
-    struct String { SpannedStr value; };
+    struct String { Spanned<StrView> value; };
     struct Call {
         Span span;
-        ::Expression *callee;
-        Vec<Type *> generic_params;
-        Vec<Argument> arguments;
+        ExprId callee;
+        Slice<const TypeNodeId> generic_params;
+        Slice<const Argument> arguments;
     };
     struct Index {
-        ::Expression *expr;
-        ::Expression *index;
+        ExprId expr;
+        ExprId index;
     };
     struct GenericInstance {
         // For example, if you have an object `object Foo[A]: ...`
         // then if you write `Foo[int]`, that would be an instance
-        ::Expression *expr;
-        Vec<Type *> generic_args;
+        ExprId expr;
+        Slice<const TypeNodeId> generic_args;
     };
     struct Unary {
         enum class Operation { Dereference, AddressOf };
 
         Operation operation;
-        ::Expression *value;
+        ExprId value;
     };
 
     struct Binary {
         enum class Operation { Equals };
 
         Operation operation;
-        ::Expression *left, *right;
+        ExprId left, right;
     };
 
     struct If {
-        ::Expression *condition;
-        ::Expression *then;
-        ::Expression *else_;
+        ExprId condition;
+        ExprId then;
+        ExprId else_;
     };
 
     struct Access {
-        ::Expression *expr;
-        ::Expression *member;
+        ExprId expr;
+        ExprId member;
     };
 
+    // The `default` case, if there is one, is a `Wildcard` pattern.
     struct Switch {
-        ::Expression *condition;
-        Vec<Pattern *> patterns;
-        Pattern *default_pattern;
+        ExprId condition;
+        Slice<Pattern *const> patterns;
     };
 
-    struct UnsafeBlock { Block<::Expression *> body; };
+    struct UnsafeBlock { Slice<const ExprId> body; };
 
 } // namespace ExpressionDetails
 
-struct Expression {
-    enum class Kind {
-        Null,
-        Id,
-        Int,
-        String,
-        Call,
-        Index,
-        GenericInstance,
-        Unary,
-        Binary,
-        If,
-        Access,
-        Switch,
-        UnsafeBlock
-    };
-
-    Var<
-            ExpressionDetails::Null *,
-            ExpressionDetails::Id *,
-            ExpressionDetails::Int *,
-            ExpressionDetails::String *,
-            ExpressionDetails::Call *,
-            ExpressionDetails::Index *,
-            ExpressionDetails::GenericInstance *,
-            ExpressionDetails::Unary *,
-            ExpressionDetails::Binary *,
-            ExpressionDetails::If *,
-            ExpressionDetails::Access *,
-            ExpressionDetails::Switch *,
-            ExpressionDetails::UnsafeBlock *> var;
-
-    [[nodiscard]] Span span() const {
-        switch (static_cast<Kind>(var.index())) {
-#define CASE(ID) case Kind::ID: { \
-            auto *expr = std::get<ExpressionDetails::ID *>(var);
-            CASE(Null) return expr->span; }
-            CASE(Id) return expr->id.span; }
-            CASE(Int) return expr->value.span; }
-            CASE(String) return expr->value.span; }
-            CASE(Call) return expr->span; }
-            CASE(Index) return expr->expr->span(); }
-            CASE(GenericInstance) return expr->expr->span(); }
-            CASE(Unary) return expr->value->span(); }
-            CASE(Binary) return expr->left->span(); }
-            CASE(If) return expr->condition->span(); }
-            CASE(Access) return expr->expr->span(); }
-            CASE(Switch) return expr->condition->span(); }
-            CASE(UnsafeBlock) return expr->body.elems[0]->span(); }
-#undef CASE
-        }
-    }
-};
-
 struct Type {
-    enum class Kind { Undetermined, Id, Str, Int, Array, Weak, Raw, Optional, Generic };
+    enum class Kind : u8 { Undetermined, Id, Str, Int, Array, Weak, Raw, Optional, Generic };
     Kind type;
-    SpannedStr id;
-    Type *subtype{}; // only for array, weak- and raw pointers, optional
-    Vec<Type *> generic_args;
-
-    bool operator==(const Type& other) const {
-        // TODO: this is sort of a hack i guess to get around not having type inference maybe?
-        if (type == Kind::Undetermined || other.type == Kind::Undetermined) return true;
-
-        if (type != other.type) return false;
-        if (type == Kind::Id) return id.value == other.id.value;
-        if (type == Kind::Array) return subtype == other.subtype;
-        if (type == Kind::Weak) return subtype == other.subtype;
-        if (type == Kind::Raw) return subtype == other.subtype;
-        if (type == Kind::Optional) return subtype == other.subtype;
-        if (type == Kind::Generic) {
-            if (id.value != other.id.value) return false;
-            if (generic_args.size() != other.generic_args.size()) return false;
-            for (usz i = 0; i < generic_args.size(); ++i) {
-                if (*generic_args[i] != *other.generic_args[i]) return false;
-            }
-        }
-        return true;
-    }
-
-    bool operator!=(const Type& other) const { return not (*this == other); }
-
-    static Str repr(Type type) {
-        switch (type.type) {
-            case Kind::Undetermined: return "<?>";
-            case Kind::Id: return type.id.value;
-            case Kind::Str: return "str";
-            case Kind::Int: return "int";
-            case Kind::Array: return std::format("[{}]", Type::repr(*type.subtype));
-            case Kind::Weak: return std::format("weak {}", Type::repr(*type.subtype));
-            case Kind::Raw: return std::format("raw {}", Type::repr(*type.subtype));
-            case Kind::Optional: return std::format("{}?", Type::repr(*type.subtype));
-            case Kind::Generic: {
-                Str repr = type.id.value;
-                repr += "[";
-                for (usz i = 0; i < type.generic_args.size(); ++i) {
-                    repr += Type::repr(*type.generic_args[i]);
-                    if (i != type.generic_args.size() - 1) repr += ", ";
-                }
-                repr += "]";
-                return repr;
-            }
-        }
-    }
+    SpannedSymbol id;
+    TypeNodeId subtype{}; // only for array, weak- and raw pointers, optional
+    Slice<const TypeNodeId> generic_args;
 };
 
 enum class PatternUnaryOperation {
@@ -253,9 +197,9 @@ enum class PatternUnaryOperation {
 namespace PatternDetails {
 
     struct Wildcard { };
-    struct Expression { ::Expression *expr; };
-    struct Range { ::Expression *from, *to; bool inclusive; };
-    struct Unary { ::Expression *value; PatternUnaryOperation operation; };
+    struct Expression { ExprId expr; };
+    struct Range { ExprId from, to; bool inclusive; };
+    struct Unary { ExprId value; PatternUnaryOperation operation; };
 
 } // namespace PatternDetails
 
@@ -269,17 +213,212 @@ struct Pattern {
     enum class Kind { Wildcard, Expression, Range, Unary };
 
     PatternCondition condition;
-    ::Expression *body;
+    ExprId body;
 };
 
+// Everything the parser produces. Expressions and type names live in
+// struct-of-arrays tables indexed by `ExprId`/`TypeNodeId`: a kind, a span and
+// three words of payload per node, with variable-length children (arguments,
+// generic arguments, block bodies) stored contiguously in side tables.
+// Declarations and statements are few and stay as structs in the arena.
+class Ast {
+  public:
+    Ast() = default;
+
+    Ast(const Ast &) = delete;
+    Ast &operator=(const Ast &) = delete;
+
+    template <typename T, typename... Args> T *make(Args &&...args) {
+        return m_arena.make<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename T> ExprId add(const T &);
+    TypeNodeId add(const Type &);
+
+    [[nodiscard]] ExprKind kind(ExprId id) const { return m_expr_kinds[id]; }
+    [[nodiscard]] Span span(ExprId id) const { return m_expr_spans[id]; }
+    template <typename T> [[nodiscard]] T get(ExprId) const;
+    [[nodiscard]] Type type(TypeNodeId) const;
+    [[nodiscard]] Str type_repr(TypeNodeId) const;
+
+    // Calls `visitor` with the `ExpressionDetails` of `id`.
+    template <typename Visitor> decltype(auto) visit(ExprId id, Visitor &&visitor) const {
+        switch (kind(id)) {
+#define X(kind) case ExprKind::kind: return visitor(get<ExpressionDetails::kind>(id));
+            EXPRESSION_KINDS
+#undef X
+        }
+        PANIC("invalid expression kind");
+    }
+
+    // The direct subexpressions of `id`, in source order.
+    template <typename F> void for_each_child(ExprId id, F &&fn) const {
+        const Node &node = m_expr_data[id];
+        switch (kind(id)) {
+            case ExprKind::Null:
+            case ExprKind::Id:
+            case ExprKind::Int:
+            case ExprKind::String: break;
+            case ExprKind::Call:
+                fn(node.a);
+                for (const Argument &argument : get<ExpressionDetails::Call>(id).arguments) fn(argument.expr);
+                break;
+            case ExprKind::Index:
+            case ExprKind::Access: fn(node.a); fn(node.b); break;
+            case ExprKind::GenericInstance:
+            case ExprKind::Unary: fn(node.a); break;
+            case ExprKind::Binary: fn(node.b); fn(node.c); break;
+            case ExprKind::If: fn(node.a); fn(node.b); fn(node.c); break;
+            case ExprKind::Switch:
+                fn(node.a);
+                for (Pattern *pattern : get<ExpressionDetails::Switch>(id).patterns) fn(pattern->body);
+                break;
+            case ExprKind::UnsafeBlock:
+                for (ExprId child : get<ExpressionDetails::UnsafeBlock>(id).body) fn(child);
+                break;
+        }
+    }
+
+    // Calls `fn` on `root` and everything below it, parents first.
+    template <typename F> void walk(ExprId root, F &&fn) const {
+        fn(root);
+        for_each_child(root, [&](ExprId child) { walk(child, fn); });
+    }
+
+    struct Stats {
+        usz expressions, types;
+        // The expression and type tables and their side tables.
+        usz bytes;
+        AstArena::Stats arena;
+    };
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    struct Node {
+        u32 a, b, c;
+    };
+
+    ExprId push(ExprKind, Span, Node);
+    template <typename T> u32 append(Vec<T> &table, Slice<const T> items) {
+        u32 start = table.size();
+        table.insert(table.end(), items.begin(), items.end());
+        return start;
+    }
+
+    Vec<ExprKind> m_expr_kinds{};
+    Vec<Span> m_expr_spans{};
+    Vec<Node> m_expr_data{};
+
+    Vec<Type::Kind> m_type_kinds{};
+    Vec<Span> m_type_spans{};
+    Vec<Node> m_type_data{};
+
+    Vec<ExprId> m_expr_lists{};
+    Vec<TypeNodeId> m_type_lists{};
+    Vec<Argument> m_arguments{};
+    Vec<Pattern *> m_patterns{};
+    Vec<Str> m_strings{};
+    // Calls need more than three words: {generics start, count, arguments start, count}.
+    Vec<u32> m_extra{};
+
+    AstArena m_arena{};
+};
+
+template <typename T> ExprId Ast::add(const T &expr) {
+    if constexpr (std::is_same_v<T, ExpressionDetails::Null>) {
+        return push(ExprKind::Null, expr.span, {});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Id>) {
+        return push(ExprKind::Id, expr.id.span, {expr.id.value, 0, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Int>) {
+        return push(ExprKind::Int, expr.value.span, {static_cast<u32>(expr.value.value), 0, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::String>) {
+        m_strings.emplace_back(expr.value.value);
+        return push(ExprKind::String, expr.value.span, {static_cast<u32>(m_strings.size() - 1), 0, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Call>) {
+        u32 extra = m_extra.size();
+        m_extra.push_back(append(m_type_lists, expr.generic_params));
+        m_extra.push_back(expr.generic_params.size());
+        m_extra.push_back(append(m_arguments, expr.arguments));
+        m_extra.push_back(expr.arguments.size());
+        return push(ExprKind::Call, expr.span, {expr.callee, extra, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Index>) {
+        return push(ExprKind::Index, span(expr.expr), {expr.expr, expr.index, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::GenericInstance>) {
+        u32 start = append(m_type_lists, expr.generic_args);
+        return push(ExprKind::GenericInstance, span(expr.expr),
+                    {expr.expr, start, static_cast<u32>(expr.generic_args.size())});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Unary>) {
+        return push(ExprKind::Unary, span(expr.value), {expr.value, static_cast<u32>(expr.operation), 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Binary>) {
+        return push(ExprKind::Binary, span(expr.left), {static_cast<u32>(expr.operation), expr.left, expr.right});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::If>) {
+        return push(ExprKind::If, span(expr.condition), {expr.condition, expr.then, expr.else_});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Access>) {
+        return push(ExprKind::Access, span(expr.expr), {expr.expr, expr.member, 0});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Switch>) {
+        u32 start = append(m_patterns, expr.patterns);
+        return push(ExprKind::Switch, span(expr.condition),
+                    {expr.condition, start, static_cast<u32>(expr.patterns.size())});
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::UnsafeBlock>) {
+        u32 start = append(m_expr_lists, expr.body);
+        Span first = expr.body.empty() ? Span{} : span(expr.body.front());
+        return push(ExprKind::UnsafeBlock, first, {start, static_cast<u32>(expr.body.size()), 0});
+    } else {
+        static_assert(sizeof(T) == 0, "not an expression");
+    }
+}
+
+template <typename T> T Ast::get(ExprId id) const {
+    const Node &node = m_expr_data[id];
+    if constexpr (std::is_same_v<T, ExpressionDetails::Null>) {
+        return ExpressionDetails::Null{span(id)};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Id>) {
+        return ExpressionDetails::Id{{node.a, span(id)}};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Int>) {
+        return ExpressionDetails::Int{{static_cast<int>(node.a), span(id)}};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::String>) {
+        return ExpressionDetails::String{{m_strings[node.a], span(id)}};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Call>) {
+        const u32 *extra = &m_extra[node.b];
+        return ExpressionDetails::Call{
+                span(id),
+                node.a,
+                Slice<const TypeNodeId>(m_type_lists.data() + extra[0], extra[1]),
+                Slice<const Argument>(m_arguments.data() + extra[2], extra[3]),
+        };
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Index>) {
+        return ExpressionDetails::Index{node.a, node.b};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::GenericInstance>) {
+        return ExpressionDetails::GenericInstance{node.a, Slice<const TypeNodeId>(m_type_lists.data() + node.b, node.c)};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Unary>) {
+        return ExpressionDetails::Unary{static_cast<ExpressionDetails::Unary::Operation>(node.b), node.a};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Binary>) {
+        return ExpressionDetails::Binary{static_cast<ExpressionDetails::Binary::Operation>(node.a), node.b, node.c};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::If>) {
+        return ExpressionDetails::If{node.a, node.b, node.c};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Access>) {
+        return ExpressionDetails::Access{node.a, node.b};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::Switch>) {
+        return ExpressionDetails::Switch{node.a, Slice<Pattern *const>(m_patterns.data() + node.b, node.c)};
+    } else if constexpr (std::is_same_v<T, ExpressionDetails::UnsafeBlock>) {
+        return ExpressionDetails::UnsafeBlock{Slice<const ExprId>(m_expr_lists.data() + node.a, node.b)};
+    } else {
+        static_assert(sizeof(T) == 0, "not an expression");
+    }
+}
+
 class AstPrinter {
 public:
+    explicit AstPrinter(const Ast &ast) : m_ast(ast) {}
+
     void print(const Vec<ParsedStatement *>&);
 
 private:
-    static void statement(ParsedStatement *);
-    static void expression(Expression *, bool = true);
-    static Str type(Type *);
-    static void field(ParsedField);
-    static void method(ParsedMethod);
-};
\ No newline at end of file
+    void statement(ParsedStatement *);
+    void expression(ExprId, bool = true);
+    Str type(TypeNodeId);
+    void field(const ParsedField &);
+    void method(const ParsedMethod &);
+
+    const Ast &m_ast;
+};
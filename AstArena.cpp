@@ -0,0 +1,23 @@
+#include "AstArena.hpp"
+#include <cstring>
+
+AstArena::~AstArena() {
+    for (auto it = m_destructors.rbegin(); it != m_destructors.rend(); ++it)
+        it->destroy(it->node);
+}
+
+AstArena::Stats AstArena::stats() const {
+    Stats stats{.used = m_memory.used(), .reserved = m_memory.reserved(), .counts = {}};
+    std::memcpy(stats.counts, m_counts, sizeof(m_counts));
+    return stats;
+}
+
+const char *AstArena::kind_name(AstNodeKind kind) {
+    switch (kind) {
+#define X(kind, type) case AstNodeKind::kind: return #kind;
+        AST_NODES
+#undef X
+        case AstNodeKind::Count: break;
+    }
+    return "?";
+}
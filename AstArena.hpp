@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "Common.hpp"
+#include <new>
+#include <type_traits>
+#include <utility>
+
+struct ParsedStatement;
+struct ParsedObject;
+struct ParsedInterface;
+struct ParsedFunction;
+struct ParsedVariable;
+struct ParsedReturn;
+struct ParsedExpression;
+struct Pattern;
+
+// The nodes allocated one by one, as `X(kind, type)`. Expressions and type
+// names are stored in the flat tables of `Ast` instead.
+#define AST_NODES                                                              \
+    X(Statement, ParsedStatement)                                              \
+    X(Object, ParsedObject)                                                    \
+    X(Interface, ParsedInterface)                                              \
+    X(Function, ParsedFunction)                                                \
+    X(Variable, ParsedVariable)                                                \
+    X(Return, ParsedReturn)                                                    \
+    X(ExpressionStatement, ParsedExpression)                                   \
+    X(Pattern, Pattern)
+
+enum class AstNodeKind {
+#define X(kind, type) kind,
+    AST_NODES
+#undef X
+    Count
+};
+
+template <typename T> struct AstNodeKindOf;
+#define X(kind, type)                                                          \
+    template <> struct AstNodeKindOf<type> {                                   \
+        static constexpr AstNodeKind value = AstNodeKind::kind;                \
+    };
+AST_NODES
+#undef X
+
+// Owns the declarations and statements of one parse. Nodes are bump-allocated
+// out of large chunks, so siblings end up next to each other, and are all
+// freed together when the arena goes away. Nodes that own memory themselves
+// (the `Vec`s in declarations and blocks) have their destructors run then, in
+// reverse order.
+class AstArena {
+  public:
+    AstArena() = default;
+    ~AstArena();
+
+    AstArena(const AstArena &) = delete;
+    AstArena &operator=(const AstArena &) = delete;
+
+    template <typename T, typename... Args> T *make(Args &&...args) {
+        void *memory = m_memory.allocate(sizeof(T), alignof(T));
+        T *node = new (memory) T{std::forward<Args>(args)...};
+        if constexpr (not std::is_trivially_destructible_v<T>)
+            m_destructors.push_back({[](void *node) { static_cast<T *>(node)->~T(); }, node});
+        m_counts[static_cast<usz>(AstNodeKindOf<T>::value)]++;
+        return node;
+    }
+
+    struct Stats {
+        // Bytes handed out to nodes, and bytes reserved in chunks.
+        usz used, reserved;
+        usz counts[static_cast<usz>(AstNodeKind::Count)];
+    };
+    [[nodiscard]] Stats stats() const;
+
+    static const char *kind_name(AstNodeKind);
+
+  private:
+    struct Destructor {
+        void (*destroy)(void *);
+        void *node;
+    };
+
+    Arena m_memory{256 * 1024, 256 * 1024};
+    Vec<Destructor> m_destructors{};
+    usz m_counts[static_cast<usz>(AstNodeKind::Count)]{};
+};
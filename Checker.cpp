@@ -1,5 +1,7 @@
 #include "Common.hpp"
 #include "Checker.hpp"
+#include "Trace.hpp"
+#include "TypeInference.hpp"
 #include <sstream>
 #include <format>
 #include <iostream>
@@ -11,17 +13,15 @@ Opt<Error> typecheck_namespace(const ParsedNamespace& parsed_namespace, ScopeId
 
     for (auto ns : parsed_namespace.namespaces) {
         ScopeId ns_scope_id = project.create_scope(scope_id);
-        project.scopes[ns_scope_id]->namespace_name = ns->name;
-        project.scopes[scope_id]->children.push_back(ns_scope_id);
+        project.scopes[ns_scope_id].namespace_name = ns->name.value_or(Symbols::Empty);
+        project.add_child_scope(scope_id, ns_scope_id);
         typecheck_namespace(*ns, ns_scope_id, project);
     }
 
     for (RecordId id = 0; id < parsed_namespace.objects.size(); id++) {
         auto object = parsed_namespace.objects[id];
         RecordId record_id = id + project_record_length;
-        project.types.push_back(CheckedType::Record(record_id));
-
-        auto object_type_id = project.types.size() - 1;
+        TypeId object_type_id = project.find_or_add_type_id(CheckedType::Record(record_id));
         ErrorOr<Void> type_error = project.add_type_to_scope(
                 scope_id,
                 object->id.value,
@@ -41,32 +41,48 @@ Opt<Error> typecheck_namespace(const ParsedNamespace& parsed_namespace, ScopeId
             error = error.value_or(x.value());
     }
 
+    Vec<Opt<Error>> record_errors(parsed_namespace.objects.size());
     for (RecordId id = 0; id < parsed_namespace.objects.size(); id++) {
         auto object = parsed_namespace.objects[id];
         RecordId record_id = id + project_record_length;
 
-        Opt<Error> x = typecheck_record(*object, record_id, scope_id, project);
-        if (x.has_value())
-            error = error.value_or(x.value());
+        record_errors[id] = typecheck_record(*object, record_id, scope_id, project);
+    }
+
+    // With every signature known, method bodies only depend on their own
+    // record, so records are checked in parallel. Errors are merged in source
+    // order afterwards, which keeps the reported one independent of scheduling.
+    Vec<Opt<Error>> body_errors(parsed_namespace.objects.size());
+    project.parallel_for(parsed_namespace.objects.size(), [&](usz id) {
+        body_errors[id] = typecheck_record_bodies(*parsed_namespace.objects[id], id + project_record_length, project);
+    });
+
+    for (RecordId id = 0; id < parsed_namespace.objects.size(); id++) {
+        if (record_errors[id].has_value()) error = error.value_or(record_errors[id].value());
+        if (body_errors[id].has_value()) error = error.value_or(body_errors[id].value());
     }
 
+    // Had the checked bodies not been deferred, their syntax errors would have
+    // been reported before anything was checked.
+    if (Opt<Error> syntax_error = project.first_syntax_error(); syntax_error.has_value()) return syntax_error;
     return error;
 }
 
 Opt<Error> typecheck_record_predecl(const ParsedObject& record, RecordId record_id, ScopeId parent_scope_id, Project& project) {
+    TraceSpan span("typecheck_record_predecl", record.id.value);
     Opt<Error> error = std::nullopt;
 
     TypeId type_id = project.find_or_add_type_id(CheckedType::Record(record_id));
     ScopeId scope_id = project.create_scope(parent_scope_id);
 
     Vec<TypeId> generic_parameters = {};
-    for (auto generic_parameter : record.generic_params) {
-        project.types.push_back(CheckedType::TypeVariable(generic_parameter->id.value));
-        TypeId parameter_type_id = project.types.size() - 1;
+    for (TypeNodeId generic_parameter_id : record.generic_params) {
+        Type generic_parameter = project.ast().type(generic_parameter_id);
+        TypeId parameter_type_id = project.find_or_add_type_id(CheckedType::TypeVariable(generic_parameter.id.value));
 
         generic_parameters.push_back(parameter_type_id);
 
-        ErrorOr<Void> x = project.add_type_to_scope(scope_id, generic_parameter->id.value, parameter_type_id, generic_parameter->id.span);
+        ErrorOr<Void> x = project.add_type_to_scope(scope_id, generic_parameter.id.value, parameter_type_id, generic_parameter.id.span);
         if (not x.has_value())
             error = error.value_or(x.error());
     }
@@ -126,6 +142,7 @@ Opt<Error> typecheck_record_predecl(const ParsedObject& record, RecordId record_
 }
 
 Opt<Error> typecheck_record(const ParsedObject& object, RecordId record_id, ScopeId parent_scope_id, Project& project) {
+    TraceSpan span("typecheck_record", object.id.value);
     Opt<Error> error = std::nullopt;
 
     Vec<CheckedVarDecl> fields = {};
@@ -161,28 +178,37 @@ Opt<Error> typecheck_record(const ParsedObject& object, RecordId record_id, Scop
                             .type_id = field.type_id,
                     }
             });
+        }
 
-            ScopeId constructor_scope_id = project.create_scope(parent_scope_id);
-            auto checked_constructor = CheckedFunction{
-                    .name = object.id.value,
-                    .return_type_id = record_type_id,
-                    .parameters = params,
-                    .generic_parameters = {},
-                    .scope_id = constructor_scope_id,
-            };
+        ScopeId constructor_scope_id = project.create_scope(parent_scope_id);
+        auto checked_constructor = CheckedFunction{
+                .name = object.id.value,
+                .return_type_id = record_type_id,
+                .parameters = params,
+                .generic_parameters = {},
+                .scope_id = constructor_scope_id,
+        };
 
-            project.functions.push_back(checked_constructor);
+        project.functions.push_back(checked_constructor);
 
-            auto x = project.add_function_to_scope(checked_record_scope_id, object.id.value,
-                                                   project.functions.size() - 1, object.id.span);
-            if (not x.has_value())
-                error = error.value_or(x.error());
-        }
+        auto x = project.add_function_to_scope(checked_record_scope_id, object.id.value,
+                                               project.functions.size() - 1, object.id.span);
+        if (not x.has_value())
+            error = error.value_or(x.error());
     }
 
     CheckedRecord record = project.records[record_id];
     record.fields = fields;
 
+    return error;
+}
+
+// Methods of the same record run one after another: two methods with the same
+// name share the scope of the first one.
+Opt<Error> typecheck_record_bodies(const ParsedObject& object, RecordId record_id, Project& project) {
+    TraceSpan span("typecheck_record_bodies", object.id.value);
+    Opt<Error> error = std::nullopt;
+
     for (const auto& fn : object.methods) {
         Opt<Error> x = typecheck_method(fn, record_id, project);
         if (x.has_value()) error = error.value_or(x.value());
@@ -192,7 +218,50 @@ Opt<Error> typecheck_record(const ParsedObject& object, RecordId record_id, Scop
 }
 
 
+// Replaces the inference variables in a checked expression's types by what
+// they were bound to. Until the function is done, later unifications may still
+// bind the variables an earlier expression was given; any left unbound then
+// become `UNKNOWN_TYPE_ID`, as their ids are reused by the next function.
+static void resolve_types(CheckedExpression *expr, TypeInference &inference, Project &project) {
+    switch (expr->tag) {
+        case CheckedExpression::Tag::Null: expr->null.type_id = inference.resolve_or_unknown(expr->null.type_id, project); break;
+        case CheckedExpression::Tag::Int:
+        case CheckedExpression::Tag::String: break;
+        case CheckedExpression::Tag::Var:
+            expr->var.var.value.type_id = inference.resolve_or_unknown(expr->var.var.value.type_id, project);
+            break;
+        case CheckedExpression::Tag::If:
+            resolve_types(expr->if_.condition, inference, project);
+            resolve_types(expr->if_.then, inference, project);
+            resolve_types(expr->if_.else_, inference, project);
+            break;
+        case CheckedExpression::Tag::BinaryOp:
+            resolve_types(expr->binary_op.left, inference, project);
+            resolve_types(expr->binary_op.right, inference, project);
+            expr->binary_op.type_id = inference.resolve_or_unknown(expr->binary_op.type_id, project);
+            break;
+        case CheckedExpression::Tag::UnaryOp:
+            resolve_types(expr->unary_op.left, inference, project);
+            expr->unary_op.type_id = inference.resolve_or_unknown(expr->unary_op.type_id, project);
+            break;
+    }
+}
+
+static void resolve_types(const CheckedBlock &block, TypeInference &inference, Project &project) {
+    for (CheckedStatement *statement : block.statements) {
+        switch (statement->tag) {
+            case CheckedStatement::Tag::Expression: resolve_types(statement->expression.expr, inference, project); break;
+            case CheckedStatement::Tag::VarDecl:
+                statement->var_decl.decl.type_id = inference.resolve_or_unknown(statement->var_decl.decl.type_id, project);
+                resolve_types(statement->var_decl.expr, inference, project);
+                break;
+            case CheckedStatement::Tag::Return: resolve_types(statement->return_.expr, inference, project); break;
+        }
+    }
+}
+
 Opt<Error> typecheck_method(const ParsedMethod& method, RecordId record_id, Project& project) {
+    TraceSpan span("typecheck_method", method.id.value);
     Opt<Error> error = std::nullopt;
 
     CheckedRecord record = project.records[record_id];
@@ -201,9 +270,9 @@ Opt<Error> typecheck_method(const ParsedMethod& method, RecordId record_id, Proj
     Opt<FunctionId> opt_method_id = project.find_function_in_scope(record_scope_id, method.id.value);
     if (not opt_method_id.has_value()) PANIC("Internal error: pushed a checked function but it's not defined.");
     FunctionId method_id = opt_method_id.value();
-    project.current_function_index = std::make_optional(method_id);
+    project.set_current_function(method_id);
 
-    CheckedFunction checked_function = project.functions[method_id];
+    const CheckedFunction &checked_function = project.functions[method_id];
     ScopeId function_scope_id = checked_function.scope_id;
 
     Vec<CheckedVariable> parameters = {};
@@ -217,7 +286,22 @@ Opt<Error> typecheck_method(const ParsedMethod& method, RecordId record_id, Proj
             error = error.value_or(x.error());
     }
 
-    auto [block, err2] = typecheck_block(method.body, function_scope_id, project, SafetyContext::Safe);
+    // A body the parser deferred is parsed here, when it is first needed.
+    Block<ParsedStatement *> deferred_body{};
+    bool deferred = method.deferred.has_value();
+    if (deferred) {
+        TraceSpan parse_span("parse_body", method.id.value);
+        Opt<Block<ParsedStatement *>> parsed = project.parse_deferred_body(method.deferred.value());
+        if (not parsed.has_value()) {
+            project.set_current_function(std::nullopt);
+            return error;
+        }
+        deferred_body = std::move(parsed).value();
+        project.begin_deferred_body();
+    }
+
+    auto [block, err2] = typecheck_block(deferred ? deferred_body : method.body, function_scope_id, project, SafetyContext::Safe);
+    if (deferred) project.end_deferred_body();
     if (err2.has_value()) error = error.value_or(err2.value());
 
     TypeId return_type_id = UNKNOWN_TYPE_ID;
@@ -229,16 +313,26 @@ Opt<Error> typecheck_method(const ParsedMethod& method, RecordId record_id, Proj
 
     if (return_type_id == UNKNOWN_TYPE_ID) return_type_id = UNIT_TYPE_ID;
 
-    CheckedFunction checked_fn = project.functions[method_id];
+    TypeInference &inference = project.inference();
+    resolve_types(block, inference, project);
+    inference.reset();
+
+    CheckedFunction &checked_fn = project.functions[method_id];
     checked_fn.block = block;
     checked_fn.return_type_id = return_type_id;
 
-    project.current_function_index = std::nullopt;
+    project.set_current_function(std::nullopt);
 
     return error;
 }
 
-std::tuple<CheckedStatement, Opt<Error>> typecheck_statement(ParsedStatement *statement, ScopeId scope_id, Project& project, SafetyContext context) {
+// Checked statements and expressions are allocated in the arena of the
+// checking thread and stay valid for as long as the project.
+template <typename T> static T *make(Project &project, const T &node) {
+    return project.checked_arena().make<T>(node);
+}
+
+std::tuple<CheckedStatement *, Opt<Error>> typecheck_statement(ParsedStatement *statement, ScopeId scope_id, Project& project, SafetyContext context) {
     Opt<Error> error = std::nullopt;
 
     switch (static_cast<ParsedStatement::Kind>(statement->var.index())) {
@@ -252,230 +346,227 @@ std::tuple<CheckedStatement, Opt<Error>> typecheck_statement(ParsedStatement *st
             UNIMPLEMENTED("Var");
         case ParsedStatement::Kind::Return: {
             auto *stmt = std::get<ParsedReturn *>(statement->var);
-            auto [output, err] = typecheck_expression(stmt->value.value(), scope_id, project, context, project.functions[project.current_function_index.value()].return_type_id);
-            return std::make_tuple(CheckedStatement::Return(&output), err);
+            auto [output, err] = typecheck_expression(stmt->value.value(), scope_id, project, context, project.functions[project.current_function().value()].return_type_id);
+            return std::make_tuple(make(project, CheckedStatement::Return(output)), err);
         }
         case ParsedStatement::Kind::Expr: {
             auto *stmt = std::get<ParsedExpression *>(statement->var);
-            auto [output, err] = typecheck_expression(stmt->expr, scope_id, project, context, project.functions[project.current_function_index.value()].return_type_id);
-            return std::make_tuple(CheckedStatement::Expression(&output), err);
+            auto [output, err] = typecheck_expression(stmt->expr, scope_id, project, context, project.functions[project.current_function().value()].return_type_id);
+            return std::make_tuple(make(project, CheckedStatement::Expression(output)), err);
         }
     }
 }
 
-std::tuple<CheckedExpression, Opt<Error>> typecheck_expression(Expression *expression, ScopeId scope_id, Project& project, SafetyContext context, Opt<TypeId> type_hint) {
+std::tuple<CheckedExpression *, Opt<Error>> typecheck_expression(ExprId expression, ScopeId scope_id, Project& project, SafetyContext context, Opt<TypeId> type_hint) {
     Opt<Error> error = std::nullopt;
 
-    auto unify_with_type_hint = [&](Project &project, TypeId type_id) -> std::tuple<TypeId, Opt<Error>> {
-        if (type_hint.has_value()) {
-            TypeId hint = type_hint.value();
-            if (hint == UNKNOWN_TYPE_ID)
-                return std::make_tuple(type_id, std::nullopt);
-
-            Map<TypeId, TypeId> generic_interface = {};
-            Opt<Error> err = check_types_for_compat(
-                    hint,
-                    type_id,
-                    &generic_interface,
-                    expression->span(),
-                    project
-            );
-            if (err.has_value())
-                return std::make_tuple(type_id, err);
-
-            return std::make_tuple(
-                    substitute_typevars_in_type(type_id, &generic_interface, project),
-                    std::nullopt
-            );
-        }
+    // Only checks that the expression's type fits the hint; the hint's type
+    // variables are solved for this expression alone.
+    auto unify_with_type_hint = [&](Project &project, TypeId type_id) -> Opt<Error> {
+        if (not type_hint.has_value() or type_hint.value() == UNKNOWN_TYPE_ID) return std::nullopt;
 
-        return std::make_tuple(type_id, std::nullopt);
+        TypeInference &inference = project.inference();
+        TypeInference::Mark mark = inference.mark();
+        Opt<Error> err = inference.unify(inference.instantiate(type_hint.value(), project), type_id, project.ast().span(expression), project);
+        inference.rollback(mark);
+        return err;
     };
 
-    switch (static_cast<Expression::Kind>(expression->var.index())) {
-        case Expression::Kind::Null: return std::make_tuple(CheckedExpression::Null(UNKNOWN_TYPE_ID), std::nullopt);
-        case Expression::Kind::Id: {
-            auto *expr = std::get<ExpressionDetails::Id *>(expression->var);
+    switch (project.ast().kind(expression)) {
+        case ExprKind::Null: {
+            // Whatever the value is compared with or assigned to decides its type.
+            TypeInference &inference = project.inference();
+            TypeId type_id = inference.fresh(project);
+            if (type_hint.has_value() and type_hint.value() != UNKNOWN_TYPE_ID)
+                (void) inference.unify(type_hint.value(), type_id, project.ast().span(expression), project);
+            // Resolved with the rest of the function, once it is all unified.
+            return std::make_tuple(make(project, CheckedExpression::Null(type_id)), std::nullopt);
+        }
+        case ExprKind::Id: {
+            auto expr = project.ast().get<ExpressionDetails::Id>(expression);
 
-            Opt<CheckedVariable> opt_var = project.find_var_in_scope(scope_id, expr->id.value);
+            Opt<CheckedVariable> opt_var = project.find_var_in_scope(scope_id, expr.id.value);
             if (not opt_var.has_value()) {
                 return std::make_tuple(
-                        CheckedExpression::Var({
-                                CheckedVariable{expr->id.value, type_hint.value_or(UNKNOWN_TYPE_ID)},
-                                expr->id.span
-                        }),
-                        Error{"variable not found", expr->id.span}
+                        make(project, CheckedExpression::Var({
+                                CheckedVariable{expr.id.value, type_hint.value_or(UNKNOWN_TYPE_ID)},
+                                expr.id.span
+                        })),
+                        Error{"variable not found", expr.id.span}
                 );
             }
             CheckedVariable var = opt_var.value();
 
-            auto [_, err] = unify_with_type_hint(project, var.type_id);
-            return std::make_tuple(CheckedExpression::Var({var, expr->id.span}), err);
+            Opt<Error> err = unify_with_type_hint(project, var.type_id);
+            return std::make_tuple(make(project, CheckedExpression::Var({var, expr.id.span})), err);
         }
-        case Expression::Kind::Int: {
-            auto *expr = std::get<ExpressionDetails::Int *>(expression->var);
+        case ExprKind::Int: {
+            auto expr = project.ast().get<ExpressionDetails::Int>(expression);
 
             // TODO: make sure integer constants can have user-specified type ids such as uint or int64
-            auto [type_id, err] = unify_with_type_hint(project, INT_TYPE_ID);
+            Opt<Error> err = unify_with_type_hint(project, INT_TYPE_ID);
             if (err.has_value()) error = error.value_or(err.value());
 
-            return std::make_tuple(CheckedExpression::Int(expr->value), error);
+            return std::make_tuple(make(project, CheckedExpression::Int(expr.value)), error);
         }
-        case Expression::Kind::String: {
-            auto *expr = std::get<ExpressionDetails::String *>(expression->var);
+        case ExprKind::String: {
+            auto expr = project.ast().get<ExpressionDetails::String>(expression);
 
-            auto [type_id, err] = unify_with_type_hint(project, STRING_TYPE_ID);
+            Opt<Error> err = unify_with_type_hint(project, STRING_TYPE_ID);
 
-            return std::make_tuple(CheckedExpression::String(expr->value), err);
+            // Copied, so the checked tree doesn't depend on how the AST stores strings.
+            std::span<char> text = project.checked_arena().copy(std::span<const char>(expr.value.value));
+            StrView value(text.data(), text.size());
+            return std::make_tuple(make(project, CheckedExpression::String({value, expr.value.span})), err);
         }
-        case Expression::Kind::Call: {
-            auto *expr = std::get<ExpressionDetails::Call *>(expression->var);
+        case ExprKind::Call: {
+            auto expr = project.ast().get<ExpressionDetails::Call>(expression);
 
-            auto [id, id_err] = typecheck_expression(expr->callee, scope_id, project, context, type_hint);
+            auto [id, id_err] = typecheck_expression(expr.callee, scope_id, project, context, type_hint);
             if (id_err.has_value()) error = error.value_or(id_err.value());
 
             UNIMPLEMENTED("Call");
         }
-        case Expression::Kind::Index:
+        case ExprKind::Index:
             UNIMPLEMENTED("Index");
-        case Expression::Kind::GenericInstance:
+        case ExprKind::GenericInstance:
             UNIMPLEMENTED("GenericInstance");
-        case Expression::Kind::Unary: {
-            auto *expr = std::get<ExpressionDetails::Unary *>(expression->var);
+        case ExprKind::Unary: {
+            auto expr = project.ast().get<ExpressionDetails::Unary>(expression);
 
-            auto [left, left_err] = typecheck_expression(expr->value, scope_id, project, context, std::nullopt);
+            auto [left, left_err] = typecheck_expression(expr.value, scope_id, project, context, std::nullopt);
             if (left_err.has_value()) error = error.value_or(left_err.value());
 
             CheckedUnaryOperator checked_op;
-            switch (expr->operation) {
+            switch (expr.operation) {
                 case ExpressionDetails::Unary::Operation::Dereference: checked_op = CheckedUnaryOperator::Dereference; break;
                 case ExpressionDetails::Unary::Operation::AddressOf: checked_op = CheckedUnaryOperator::AddressOf; break;
             }
 
-            auto [checked_expr, err] = typecheck_unary_operation(&left, checked_op, expression->span(), project, context);
+            auto [checked_expr, err] = typecheck_unary_operation(left, checked_op, project.ast().span(expression), project, context);
             if (err.has_value()) error = error.value_or(err.value());
 
             return std::make_tuple(checked_expr, error);
         }
-        case Expression::Kind::Binary: {
-            auto *expr = std::get<ExpressionDetails::Binary *>(expression->var);
+        case ExprKind::Binary: {
+            auto expr = project.ast().get<ExpressionDetails::Binary>(expression);
 
-            auto [left, left_err] = typecheck_expression(expr->left, scope_id, project, context, std::nullopt);
+            auto [left, left_err] = typecheck_expression(expr.left, scope_id, project, context, std::nullopt);
             if (left_err.has_value()) error = error.value_or(left_err.value());
 
-            auto [right, right_err] = typecheck_expression(expr->right, scope_id, project, context, std::nullopt);
+            auto [right, right_err] = typecheck_expression(expr.right, scope_id, project, context, std::nullopt);
             if (right_err.has_value()) error = error.value_or(right_err.value());
 
-            auto [type_id, bin_err] = typecheck_binary_operation(&left, expr->operation, &right, expression->span(), project);
+            auto [type_id, bin_err] = typecheck_binary_operation(left, expr.operation, right, project.ast().span(expression), project);
             if (bin_err.has_value()) error = error.value_or(bin_err.value());
 
-            auto [unified_type_id, err] = unify_with_type_hint(project, type_id);
+            Opt<Error> err = unify_with_type_hint(project, type_id);
             if (err.has_value()) error = error.value_or(err.value());
 
-            return std::make_tuple(CheckedExpression::BinaryOp(&left, expr->operation, &right, expression->span(), type_id), error);
+            return std::make_tuple(make(project, CheckedExpression::BinaryOp(left, expr.operation, right, project.ast().span(expression), type_id)), error);
         }
-        case Expression::Kind::If: {
-            auto *expr = std::get<ExpressionDetails::If *>(expression->var);
+        case ExprKind::If: {
+            auto expr = project.ast().get<ExpressionDetails::If>(expression);
 
-            auto [cond, cond_err] = typecheck_expression(expr->condition, scope_id, project, context, type_hint);
+            auto [cond, cond_err] = typecheck_expression(expr.condition, scope_id, project, context, type_hint);
             if (cond_err.has_value()) error = error.value_or(cond_err.value());
 
-            auto [then, then_err] = typecheck_expression(expr->then, scope_id, project, context, type_hint);
+            auto [then, then_err] = typecheck_expression(expr.then, scope_id, project, context, type_hint);
             if (then_err.has_value()) error = error.value_or(then_err.value());
 
-            auto [else_, else_err] = typecheck_expression(expr->else_, scope_id, project, context, type_hint);
+            auto [else_, else_err] = typecheck_expression(expr.else_, scope_id, project, context, type_hint);
             if (else_err.has_value()) error = error.value_or(else_err.value());
 
-            return std::make_tuple(CheckedExpression::If(&cond, &then, &else_), error);
+            return std::make_tuple(make(project, CheckedExpression::If(cond, then, else_)), error);
         }
-        case Expression::Kind::Access:
+        case ExprKind::Access:
             UNIMPLEMENTED("Access");
-        case Expression::Kind::Switch:
+        case ExprKind::Switch:
             UNIMPLEMENTED("Switch");
-        case Expression::Kind::UnsafeBlock:
+        case ExprKind::UnsafeBlock:
             UNIMPLEMENTED("UnsafeBlock");
     }
 }
 
 std::tuple<CheckedBlock, Opt<Error>> typecheck_block(const Block<ParsedStatement *>& block, ScopeId parent_scope_id, Project& project, SafetyContext context) {
     Opt<Error> error = std::nullopt;
-    CheckedBlock checked_block = {{}};
+    Vec<CheckedStatement *> statements = {};
 
     ScopeId block_scope_id = project.create_scope(parent_scope_id);
 
     for (const auto &stmt : block.elems) {
         auto [checked_stmt, err] = typecheck_statement(stmt, block_scope_id, project, context);
         if (err.has_value()) error = error.value_or(err.value());
-        checked_block.statements.push_back(&checked_stmt);
+        statements.push_back(checked_stmt);
     }
 
+    CheckedBlock checked_block = {project.checked_arena().copy(std::span<CheckedStatement *const>(statements))};
     return std::make_tuple(checked_block, error);
 }
 
-std::tuple<TypeId, Opt<Error>> typecheck_typename(Type *unchecked_type, ScopeId scope_id, Project& project) {
+std::tuple<TypeId, Opt<Error>> typecheck_typename(TypeNodeId type_node_id, ScopeId scope_id, Project& project) {
     Opt<Error> error = std::nullopt;
+    Type unchecked_type = project.ast().type(type_node_id);
 
-    switch (unchecked_type->type) {
-        case Type::Kind::Undetermined: return std::make_tuple(UNKNOWN_TYPE_ID, std::nullopt);
+    switch (unchecked_type.type) {
+        case Type::Kind::Undetermined: return std::make_tuple(project.inference().fresh(project), std::nullopt);
         case Type::Kind::Id: {
-            Opt<TypeId> type_id = project.find_type_in_scope(scope_id, unchecked_type->id.value);
+            Opt<TypeId> type_id = project.find_type_in_scope(scope_id, unchecked_type.id.value);
             if (type_id.has_value())
                 return std::make_tuple(type_id.value(), std::nullopt);
             else
-                return std::make_tuple(UNKNOWN_TYPE_ID, std::make_optional(Error{"unknown type", unchecked_type->id.span}));
+                return std::make_tuple(UNKNOWN_TYPE_ID, std::make_optional(Error{"unknown type", unchecked_type.id.span}));
         }
         case Type::Kind::Str: return std::make_tuple(STRING_TYPE_ID, std::nullopt);
         case Type::Kind::Int: return std::make_tuple(INT_TYPE_ID, std::nullopt);
-        case Type::Kind::Array: {
-            auto [inner_type_id, err] = typecheck_typename(unchecked_type->subtype, scope_id, project);
+        case Type::Kind::Array:
+        case Type::Kind::Weak:
+        case Type::Kind::Optional: {
+            auto [inner_type_id, err] = typecheck_typename(unchecked_type.subtype, scope_id, project);
             if (err.has_value()) error = error.value_or(err.value());
 
-            Opt<RecordId> opt_array_record_id = project
-                    .find_record_in_scope(0, "Array");
-            if (not opt_array_record_id.has_value())
-                PANIC("internal error: `Array` builtin was not found");
-            RecordId array_record_id = opt_array_record_id.value();
-
-            TypeId type_id = project.find_or_add_type_id(CheckedType::GenericInstance(array_record_id, {inner_type_id}));
+            RecordId record_id = unchecked_type.type == Type::Kind::Array  ? ARRAY_RECORD_ID
+                               : unchecked_type.type == Type::Kind::Weak ? WEAK_PTR_RECORD_ID
+                                                                         : OPTIONAL_RECORD_ID;
+            TypeId type_id = project.find_or_add_type_id(CheckedType::GenericInstance(record_id, {inner_type_id}));
 
             return std::make_tuple(type_id, error);
         }
-        case Type::Kind::Weak: break;
         case Type::Kind::Raw: {
-            auto [inner_type_id, err] = typecheck_typename(unchecked_type->subtype, scope_id, project);
+            auto [inner_type_id, err] = typecheck_typename(unchecked_type.subtype, scope_id, project);
             if (err.has_value()) error = error.value_or(err.value());
 
             TypeId type_id = project.find_or_add_type_id(CheckedType::RawPtr(inner_type_id));
 
             return std::make_tuple(type_id, error);
         }
-        case Type::Kind::Optional: break;
         case Type::Kind::Generic: {
             Vec<TypeId> checked_inner_types = {};
 
-            for (const auto& inner_type : unchecked_type->generic_args) {
+            for (const auto& inner_type : unchecked_type.generic_args) {
                 auto [inner_type_id, err] = typecheck_typename(inner_type, scope_id, project);
                 if (err.has_value()) error = error.value_or(err.value());
 
                 checked_inner_types.push_back(inner_type_id);
             }
 
-            Opt<RecordId> record_id = project.find_record_in_scope(scope_id, unchecked_type->id.value);
+            Opt<RecordId> record_id = project.find_record_in_scope(scope_id, unchecked_type.id.value);
             if (record_id.has_value())
                 return std::make_tuple(project.find_or_add_type_id(CheckedType::GenericInstance(record_id.value(), checked_inner_types)), error);
-            else return std::make_tuple(UNKNOWN_TYPE_ID, std::make_optional(Error{std::format("undefined type `{}`", unchecked_type->id.value), unchecked_type->id.span}));
+            else return std::make_tuple(UNKNOWN_TYPE_ID, std::make_optional(Error{std::format("undefined type `{}`", interner.text(unchecked_type.id.value)), unchecked_type.id.span}));
         }
     }
 }
 
 std::tuple<TypeId, Opt<Error>> typecheck_binary_operation(CheckedExpression *left, ExpressionDetails::Binary::Operation op, CheckedExpression *right, Span span, Project &project) {
-    const TypeId left_type_id = left->type_id();
-    const TypeId right_type_id = right->type_id();
+    TypeInference &inference = project.inference();
+    const TypeId left_type_id = inference.resolve(left->type_id(), project);
+    const TypeId right_type_id = inference.resolve(right->type_id(), project);
 
-    TypeId type_id = left->type_id();
+    TypeId type_id = left_type_id;
     switch (op) {
         case ExpressionDetails::Binary::Operation::Equals:
-            if (left_type_id != right_type_id) {
+            if (inference.unify(left_type_id, right_type_id, span, project).has_value()) {
                 return std::make_tuple(left_type_id, Error{
                         std::format("binary comparison operation between incompatible types ({} and {})",
                                     project.typename_for_type_id(left_type_id),
@@ -490,20 +581,20 @@ std::tuple<TypeId, Opt<Error>> typecheck_binary_operation(CheckedExpression *lef
     return std::make_tuple(type_id, std::nullopt);
 }
 
-std::tuple<CheckedExpression, Opt<Error>> typecheck_unary_operation(CheckedExpression *expr, CheckedUnaryOperator op, Span span, Project &project, SafetyContext context) {
-    TypeId expr_type_id = expr->type_id();
-    CheckedType expr_type = project.types[expr_type_id];
+std::tuple<CheckedExpression *, Opt<Error>> typecheck_unary_operation(CheckedExpression *expr, CheckedUnaryOperator op, Span span, Project &project, SafetyContext context) {
+    TypeId expr_type_id = project.inference().resolve(expr->type_id(), project);
+    const CheckedType &expr_type = project.types[expr_type_id];
 
     switch (op) {
         case Dereference: {
             switch (expr_type.tag) {
                 case CheckedType::Tag::RawPtr:
-                    return std::make_tuple(CheckedExpression::UnaryOp(expr, op, span, expr_type.rawptr.subtype),
+                    return std::make_tuple(make(project, CheckedExpression::UnaryOp(expr, op, span, expr_type.rawptr.subtype)),
                                            context == SafetyContext::Unsafe ? std::nullopt : std::make_optional(Error{
                             "dereference of raw pointer outside of unsafe block",
                             span
                     }));
-                default: return std::make_tuple(CheckedExpression::UnaryOp(expr, op, span, UNKNOWN_TYPE_ID), Error{
+                default: return std::make_tuple(make(project, CheckedExpression::UnaryOp(expr, op, span, UNKNOWN_TYPE_ID)), Error{
                         "dereference of a non-pointer value",
                         span
                 });
@@ -512,161 +603,59 @@ std::tuple<CheckedExpression, Opt<Error>> typecheck_unary_operation(CheckedExpre
         case AddressOf: {
             TypeId type_id = project.find_or_add_type_id(CheckedType::RawPtr(expr->type_id()));
 
-            return std::make_tuple(CheckedExpression::UnaryOp(expr, op, span, type_id), std::nullopt);
+            return std::make_tuple(make(project, CheckedExpression::UnaryOp(expr, op, span, type_id)), std::nullopt);
         }
     }
 }
 
 TypeId substitute_typevars_in_type(TypeId type_id, Map<TypeId, TypeId> *generic_inferences, Project &project) {
-    TypeId result = substitute_typevars_in_type_helper(type_id, generic_inferences, project);
-
-    for (;;) {
-        TypeId fixed_point = substitute_typevars_in_type_helper(type_id, generic_inferences, project);
-        if (fixed_point == result) break;
-        else result = fixed_point;
-    }
-
-    return result;
+    SubstitutionId substitution = project.find_or_add_substitution(*generic_inferences);
+    return substitute_typevars_in_type_helper(type_id, generic_inferences, substitution, project);
 }
 
-TypeId substitute_typevars_in_type_helper(TypeId type_id, Map<TypeId, TypeId> *generic_inferences, Project &project) {
-    CheckedType type = project.types[type_id];
+// Rebuilds a type bottom-up from substituted arguments. What a type variable
+// maps to is substituted again, so chains like `A -> B, B -> int` resolve all
+// the way; a variable that maps back onto itself stays as it is.
+TypeId substitute_typevars_in_type_helper(TypeId type_id, Map<TypeId, TypeId> *generic_inferences, SubstitutionId substitution, Project &project) {
+    if (Opt<TypeId> cached = project.find_substituted_type(type_id, substitution); cached.has_value())
+        return cached.value();
+
+    TypeId result = type_id;
+    const CheckedType &type = project.types[type_id];
     switch (type.tag) {
         case CheckedType::Tag::TypeVariable:
-            if (generic_inferences->contains(type_id))
-                return generic_inferences->at(type_id);
+            if (auto it = generic_inferences->find(type_id); it != generic_inferences->end()) {
+                // Seen while it is being substituted, the variable stands for
+                // itself; that ends cycles such as `A -> B, B -> A`.
+                project.add_substituted_type(type_id, substitution, type_id);
+                result = substitute_typevars_in_type_helper(it->second, generic_inferences, substitution, project);
+            }
             break;
         case CheckedType::Tag::GenericInstance: {
             RecordId record_id = type.generic_instance.record_id;
             Vec<TypeId> args = type.generic_instance.generic_arguments;
 
-            for (TypeId& idx : args) {
-                TypeId *arg = &idx;
-                *arg = substitute_typevars_in_type(*arg, generic_inferences, project);
-            }
+            for (TypeId& arg : args)
+                arg = substitute_typevars_in_type_helper(arg, generic_inferences, substitution, project);
 
-            return project.find_or_add_type_id(CheckedType::GenericInstance(record_id, args));
+            result = project.find_or_add_type_id(CheckedType::GenericInstance(record_id, args));
         } break;
         case CheckedType::Tag::Record: {
             RecordId record_id = type.record.record_id;
-            CheckedRecord record = project.records[record_id];
+            const CheckedRecord &record = project.records[record_id];
 
             if (not record.generic_parameters.empty()) {
                 Vec<TypeId> args = record.generic_parameters;
 
-                for (TypeId& idx : args) {
-                    TypeId *arg = &idx;
-                    *arg = substitute_typevars_in_type(*arg, generic_inferences, project);
-                }
+                for (TypeId& arg : args)
+                    arg = substitute_typevars_in_type_helper(arg, generic_inferences, substitution, project);
 
-                return project.find_or_add_type_id(CheckedType::GenericInstance(record_id, args));
+                result = project.find_or_add_type_id(CheckedType::GenericInstance(record_id, args));
             }
         } break;
         default: break;
     }
-    return type_id;
-}
-
-Opt<Error> check_types_for_compat(
-        TypeId lhs_type_id,
-        TypeId rhs_type_id,
-        Map<TypeId, TypeId> *generic_inferences,
-        Span span,
-        Project &project
-) {
-    Opt<Error> error = std::nullopt;
-    CheckedType lhs_type = project.types[lhs_type_id];
-
-    Opt<RecordId> opt_optional_record_id = project.find_record_in_scope(0, "Optional");
-    if (not opt_optional_record_id.has_value())
-        PANIC("internal error: `Optional` builtin was not found");
-    RecordId optional_record_id = opt_optional_record_id.value();
-
-    Opt<RecordId> opt_weak_ptr_record_id = project.find_record_in_scope(0, "WeakPtr");
-    if (not opt_weak_ptr_record_id.has_value())
-        PANIC("internal error: `WeakPtr` builtin was not found");
-    RecordId weak_ptr_record_id = opt_weak_ptr_record_id.value();
-
-    if (lhs_type.tag == CheckedType::Tag::GenericInstance) {
-        RecordId lhs_struct_id = lhs_type.generic_instance.record_id;
-        Vec<TypeId> args = lhs_type.generic_instance.generic_arguments;
-
-        if ((lhs_struct_id == optional_record_id or lhs_struct_id == weak_ptr_record_id) and args.front() == rhs_type_id) {
-            return std::nullopt;
-        }
-    }
-
-    switch (lhs_type.tag) {
-        case CheckedType::Tag::TypeVariable: {
-            if (generic_inferences->contains(lhs_type_id)) {
-                TypeId seen_type_id = generic_inferences->at(lhs_type_id);
-
-                if (rhs_type_id != seen_type_id) {
-                    error = error.value_or(Error{
-                            std::format("type mismatch; expected {}, but got {} instead",
-                                        project.typename_for_type_id(seen_type_id),
-                                        project.typename_for_type_id(rhs_type_id)),
-                            span
-                    });
-                }
-            } else {
-                generic_inferences->insert({lhs_type_id, rhs_type_id});
-            }
-        } break;
-        case CheckedType::Tag::GenericInstance: {
-            RecordId lhs_record_id = lhs_type.generic_instance.record_id;
-            Vec<TypeId> lhs_args = lhs_type.generic_instance.generic_arguments;
-            CheckedType rhs_type = project.types[rhs_type_id];
-            if (rhs_type.tag == CheckedType::Tag::GenericInstance) {
-                RecordId rhs_record_id = rhs_type.generic_instance.record_id;
-                if (lhs_record_id == rhs_record_id) {
-                    Vec<TypeId> rhs_args = rhs_type.generic_instance.generic_arguments;
-
-                    CheckedRecord lhs_record = project.records[lhs_record_id];
-                    if (rhs_args.size() != lhs_args.size())
-                        return Error{
-                                std::format("mismatched number of generic parameters for {}", lhs_record.name),
-                                span
-                        };
-
-                    for (usz idx = 0; idx < lhs_args.size(); idx++) {
-                        TypeId lhs_arg_type_id = lhs_args[idx];
-                        TypeId rhs_arg_type_id = rhs_args[idx];
-
-                        Opt<Error> err = check_types_for_compat(lhs_arg_type_id, rhs_arg_type_id, generic_inferences, span, project);
-                        if (err.has_value()) return err.value();
-                    }
-                }
-            } else {
-                if (rhs_type_id != lhs_type_id) {
-                    error = error.value_or(Error{
-                            std::format("type mismatch; expected {}, but got {} instead",
-                                        project.typename_for_type_id(lhs_type_id),
-                                        project.typename_for_type_id(rhs_type_id)),
-                            span
-                    });
-                }
-            }
-        } break;
-        case CheckedType::Tag::Record: {
-            if (rhs_type_id == lhs_type_id) return std::nullopt;
-            else error = error.value_or(Error{
-                        std::format("type mismatch; expected {}, but got {} instead",
-                                    project.typename_for_type_id(lhs_type_id),
-                                    project.typename_for_type_id(rhs_type_id)),
-                        span
-                });
-        } break;
-        default:
-            if (rhs_type_id != lhs_type_id)
-                error = error.value_or(Error{
-                        std::format("type mismatch; expected {}, but got {} instead",
-                                    project.typename_for_type_id(lhs_type_id),
-                                    project.typename_for_type_id(rhs_type_id)),
-                        span
-                });
-            break;
-    }
 
-    return error;
+    project.add_substituted_type(type_id, substitution, result);
+    return result;
 }
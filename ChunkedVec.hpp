@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Common.hpp"
+#include <atomic>
+#include <bit>
+#include <new>
+#include <utility>
+
+// A growable array whose elements never move. Chunk `k` holds `64 << k`
+// elements, so indexing is a couple of bit operations and there are never
+// more than a few dozen chunks. Since nothing is ever relocated, `append` can
+// be called from several threads at once while others read elements they
+// already know the index of.
+template <typename T> class ChunkedVec {
+  public:
+    ChunkedVec() = default;
+    ~ChunkedVec() {
+        usz size = this->size();
+        for (usz i = 0; i < size; i++) (*this)[i].~T();
+        for (usz k = 0; k < MAX_CHUNKS; k++) {
+            T *chunk = m_chunks[k].load(std::memory_order_relaxed);
+            if (chunk != nullptr) ::operator delete(chunk, std::align_val_t{alignof(T)});
+        }
+    }
+
+    ChunkedVec(const ChunkedVec &) = delete;
+    ChunkedVec &operator=(const ChunkedVec &) = delete;
+
+    // Constructs a new element in place and returns its index.
+    template <typename... Args> usz append(Args &&...args) {
+        usz index = m_size.fetch_add(1, std::memory_order_relaxed);
+        auto [k, offset] = locate(index);
+        T *chunk = m_chunks[k].load(std::memory_order_acquire);
+        if (chunk == nullptr) chunk = allocate_chunk(k);
+        new (chunk + offset) T(std::forward<Args>(args)...);
+        return index;
+    }
+
+    T &operator[](usz index) {
+        auto [k, offset] = locate(index);
+        return m_chunks[k].load(std::memory_order_acquire)[offset];
+    }
+    const T &operator[](usz index) const {
+        auto [k, offset] = locate(index);
+        return m_chunks[k].load(std::memory_order_acquire)[offset];
+    }
+
+    [[nodiscard]] usz size() const { return m_size.load(std::memory_order_relaxed); }
+
+  private:
+    static constexpr usz FIRST_CHUNK_BITS = 6;
+    static constexpr usz MAX_CHUNKS = 64 - FIRST_CHUNK_BITS;
+
+    struct Location {
+        usz chunk, offset;
+    };
+    static Location locate(usz index) {
+        usz biased = index + (1ul << FIRST_CHUNK_BITS);
+        usz chunk = std::bit_width(biased) - 1 - FIRST_CHUNK_BITS;
+        return Location{chunk, biased - (1ul << (chunk + FIRST_CHUNK_BITS))};
+    }
+
+    T *allocate_chunk(usz k) {
+        usz count = 1ul << (k + FIRST_CHUNK_BITS);
+        auto *chunk = static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{alignof(T)}));
+        T *expected = nullptr;
+        if (m_chunks[k].compare_exchange_strong(expected, chunk, std::memory_order_acq_rel)) return chunk;
+        // Another thread got there first.
+        ::operator delete(chunk, std::align_val_t{alignof(T)});
+        return expected;
+    }
+
+    std::atomic<T *> m_chunks[MAX_CHUNKS]{};
+    std::atomic<usz> m_size{0};
+};
@@ -1,17 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 #include <functional>
 #include <map>
 #include <memory>
+#include <utility>
 
 using u8 = unsigned char;
+using u16 = unsigned short;
+using u32 = unsigned int;
 using usz = unsigned long;
 
 using Str = std::string;
+using StrView = std::string_view;
 template <typename T> using Opt = std::optional<T>;
 template <typename T> using Vec = std::vector<T>;
 template <typename T> using Unique = std::unique_ptr<T>;
@@ -21,23 +28,28 @@ template <typename T> using Fn = std::function<T>;
 
 struct Void {};
 
+using FileId = u16;
+// An interned identifier; see `Interner`.
+using Symbol = u32;
+
+// A range of bytes in one of the files of a `SourceMap`. Lines and columns
+// are only worked out when a diagnostic is printed; lengths beyond 64 KiB
+// saturate, which only shortens an underline.
 struct Span {
-    const char *filename;
-    usz line, column, length;
+    u32 offset{};
+    FileId file_id{};
+    u16 length{};
+
+    Span() = default;
+    Span(FileId file_id, usz offset, usz length)
+            : offset(offset), file_id(file_id), length(std::min<usz>(length, UINT16_MAX)) {}
+
+    [[nodiscard]] usz end() const { return offset + length; }
 
     Span extend(Span other) {
-        if (other.line < line) {
-            line = other.line;
-            column = other.column;
-        }
-        if (other.line == line and other.column < column) {
-            column = other.column;
-        }
-        if (other.line == line and other.column == column and other.length > length) {
-            length = other.length;
-        }
-
-        return *this;
+        usz start = std::min(offset, other.offset);
+        usz stop = std::max(end(), other.end());
+        return *this = Span{file_id, start, stop - start};
     }
 };
 
@@ -47,11 +59,12 @@ template <typename T> struct Spanned {
 };
 
 template <typename T> struct Id {
-    Str id;
+    Symbol id;
     T value;
 };
 
 using SpannedStr = Spanned<Str>;
+using SpannedSymbol = Spanned<Symbol>;
 
 struct Error {
     Str message;
@@ -61,25 +74,33 @@ struct Error {
 template <typename T> requires (not std::is_same_v<T, Error>)
 class ErrorOr {
 public:
-    ErrorOr(T value) : m_has_value(true), m_result_or_error(value) {}
-    ErrorOr(Error error) : m_has_value(false), m_result_or_error(error) {}
+    ErrorOr(T value) : m_has_value(true), m_result_or_error(std::in_place_index<0>, std::move(value)) {}
+    ErrorOr(Error error) : m_has_value(false), m_result_or_error(std::in_place_index<1>, std::move(error)) {}
 
     [[nodiscard]] bool has_value() const { return m_has_value; }
-    T value() const { return std::get<T>(m_result_or_error); }
-    [[nodiscard]] Error error() const { return std::get<Error>(m_result_or_error); }
+    // As with `std::expected`, a temporary hands its contents over instead of
+    // copying them.
+    [[nodiscard]] T &value() & { return std::get<0>(m_result_or_error); }
+    [[nodiscard]] const T &value() const & { return std::get<0>(m_result_or_error); }
+    [[nodiscard]] T &&value() && { return std::get<0>(std::move(m_result_or_error)); }
+    [[nodiscard]] const Error &error() const & { return std::get<1>(m_result_or_error); }
+    [[nodiscard]] Error &&error() && { return std::get<1>(std::move(m_result_or_error)); }
 
-    T value_or(T other) { return m_has_value ? value() : other; }
+    T value_or(T other) const & { return m_has_value ? value() : std::move(other); }
+    T value_or(T other) && { return m_has_value ? std::move(*this).value() : std::move(other); }
 
 private:
     bool m_has_value;
     Var<T, Error> m_result_or_error;
 };
 
+// Moves the value (or the error) out of the temporary, so unwrapping a vector
+// or a method doesn't copy it.
 #define try$(expr) \
     ({              \
         auto __temp_val = (expr); \
-        if (not __temp_val.has_value()) return __temp_val.error(); \
-        __temp_val.value();       \
+        if (not __temp_val.has_value()) return std::move(__temp_val).error(); \
+        std::move(__temp_val).value(); \
     })
 
 #define PANIC(msg, ...) panic(__FILE__, __LINE__, msg, ##__VA_ARGS__)
@@ -89,15 +110,3 @@ private:
 #define STRINGIFY(x) STRINGIFY_HELPER(x)
 
 [[noreturn]] void panic(const char *file, usz line, const char *fmt, ...);
-
-static inline std::vector<std::string> split(std::string str, char delim = ' ') {
-    std::vector<std::string> result;
-    size_t start = 0;
-    while (start < str.length()) {
-        size_t pos = str.find(delim, start);
-        if (pos == std::string::npos) pos = str.length();
-        result.push_back(str.substr(start, pos - start));
-        start = pos + 1;
-    }
-    return result;
-}
\ No newline at end of file
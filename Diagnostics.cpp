@@ -0,0 +1,48 @@
+#include "Diagnostics.hpp"
+#include <charconv>
+
+static StrView format_number(char (&digits)[20], usz value) {
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    return {digits, end};
+}
+
+void Diagnostics::error(const Error &error) {
+    const Span &span = error.span;
+    const SourceFile &file = m_sources.file(span.file_id);
+    auto [line, column] = file.location(span.offset);
+    char line_digits[20], column_digits[20];
+    StrView line_number = format_number(line_digits, line);
+
+    m_buffer += "\033[1;1m";
+    m_buffer += file.filename();
+    m_buffer += ':';
+    m_buffer += line_number;
+    m_buffer += ':';
+    m_buffer += format_number(column_digits, column);
+    m_buffer += ": \033[31;1merror: \033[0m";
+    m_buffer += error.message;
+    m_buffer += '\n';
+
+    // TODO: highlight the snippet by tokenizing `file.line(line)`.
+    m_buffer += "\033[36;1m ";
+    m_buffer += line_number;
+    m_buffer += " | \033[0m";
+    m_buffer += file.line(line);
+    m_buffer += '\n';
+
+    m_buffer += "\033[36;1m ";
+    m_buffer.append(line_number.size(), ' ');
+    m_buffer += " | \033[31;1m";
+    m_buffer.append(column - 1, ' ');
+    m_buffer += '^';
+    m_buffer.append(std::max<usz>(span.length, 1) - 1, '~');
+    m_buffer += '\n';
+
+    m_count++;
+}
+
+void Diagnostics::flush(std::ostream &out) {
+    out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+    out.flush();
+    m_buffer.clear();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Source.hpp"
+#include <ostream>
+
+// Renders errors with the offending source line underneath. Everything is
+// formatted into one buffer and written out in a single call by `flush()`.
+class Diagnostics {
+  public:
+    explicit Diagnostics(const SourceMap &sources) : m_sources(sources) {}
+
+    void error(const Error &);
+    void flush(std::ostream &);
+
+    [[nodiscard]] usz count() const { return m_count; }
+
+  private:
+    const SourceMap &m_sources;
+    Str m_buffer{};
+    usz m_count{0};
+};
@@ -0,0 +1,95 @@
+#include "Interner.hpp"
+#include <cstring>
+
+static constexpr usz CHUNK_SIZE = 64 * 1024;
+
+// Identifiers are short, so mix them in eight bytes at a time.
+static u32 hash_text(StrView text) {
+    constexpr unsigned long long multiplier = 0x9E3779B97F4A7C15ull;
+    unsigned long long hash = text.size() * multiplier;
+    const char *p = text.data();
+    usz remaining = text.size();
+    for (; remaining >= 8; p += 8, remaining -= 8) {
+        unsigned long long word;
+        std::memcpy(&word, p, 8);
+        hash = (hash ^ word) * multiplier;
+    }
+    if (remaining > 0) {
+        unsigned long long word = 0;
+        std::memcpy(&word, p, remaining);
+        hash = (hash ^ word) * multiplier;
+    }
+    return static_cast<u32>(hash >> 32);
+}
+
+Interner::Interner() : m_slots(1024, Slot{0, EMPTY_SLOT}) {
+#define X(id, text) intern(text);
+    WELL_KNOWN_SYMBOLS
+#undef X
+    // Don't count the well-known names as lookups.
+    m_lookups.store(0, std::memory_order_relaxed);
+    m_hits.store(0, std::memory_order_relaxed);
+}
+
+Symbol Interner::intern(StrView text) {
+    m_lookups.store(m_lookups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    u32 hash = hash_text(text);
+    usz mask = m_slots.size() - 1;
+    for (usz i = hash & mask;; i = (i + 1) & mask) {
+        Slot &slot = m_slots[i];
+        if (slot.symbol == EMPTY_SLOT) break;
+        if (slot.hash == hash and m_texts[slot.symbol] == text) {
+            m_hits.store(m_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return slot.symbol;
+        }
+    }
+
+    // Keep the table at most half full.
+    if ((m_texts.size() + 1) * 2 > m_slots.size()) grow();
+
+    Symbol symbol = m_texts.size();
+    m_texts.emplace_back(store(text), text.size());
+    mask = m_slots.size() - 1;
+    usz i = hash & mask;
+    while (m_slots[i].symbol != EMPTY_SLOT) i = (i + 1) & mask;
+    m_slots[i] = Slot{hash, symbol};
+    return symbol;
+}
+
+const char *Interner::store(StrView text) {
+    if (text.size() > m_remaining) {
+        usz size = std::max(CHUNK_SIZE, text.size());
+        m_chunks.push_back(std::make_unique<char[]>(size));
+        m_chunk_bytes += size;
+        m_cursor = m_chunks.back().get();
+        m_remaining = size;
+    }
+    char *stored = m_cursor;
+    std::memcpy(stored, text.data(), text.size());
+    m_cursor += text.size();
+    m_remaining -= text.size();
+    return stored;
+}
+
+void Interner::grow() {
+    Vec<Slot> slots(m_slots.size() * 2, Slot{0, EMPTY_SLOT});
+    usz mask = slots.size() - 1;
+    for (const Slot &slot : m_slots) {
+        if (slot.symbol == EMPTY_SLOT) continue;
+        usz i = slot.hash & mask;
+        while (slots[i].symbol != EMPTY_SLOT) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+    m_slots = std::move(slots);
+}
+
+Interner::Stats Interner::stats() const {
+    return Stats{
+        .lookups = m_lookups.load(std::memory_order_relaxed),
+        .hits = m_hits.load(std::memory_order_relaxed),
+        .symbols = m_texts.size(),
+        .bytes = m_chunk_bytes + m_slots.capacity() * sizeof(Slot) + m_texts.capacity() * sizeof(StrView),
+    };
+}
+
+Interner interner{};
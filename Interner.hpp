@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Common.hpp"
+#include <atomic>
+
+// Names the checker refers to directly. They are interned first, in this
+// order, so their symbols are constants; `Empty` makes a default `Symbol{}`
+// read as the empty string.
+#define WELL_KNOWN_SYMBOLS                                                     \
+    X(Empty, "")                                                               \
+    X(Array, "Array")                                                          \
+    X(Optional, "Optional")                                                    \
+    X(WeakPtr, "WeakPtr")                                                      \
+    X(T, "T")
+
+namespace Symbols {
+enum : Symbol {
+#define X(id, text) id,
+    WELL_KNOWN_SYMBOLS
+#undef X
+};
+} // namespace Symbols
+
+// Maps every distinct identifier to a small integer, so names are hashed once
+// when they are lexed and compared as integers from then on. The text lives
+// in an append-only arena and stays valid for the life of the interner.
+class Interner {
+  public:
+    Interner();
+
+    Interner(const Interner &) = delete;
+    Interner &operator=(const Interner &) = delete;
+
+    // Only reads the table for names already interned, so threads may intern
+    // names they know to be there (such as when lexing source a second time)
+    // while nothing adds new ones.
+    Symbol intern(StrView);
+    [[nodiscard]] StrView text(Symbol symbol) const { return m_texts[symbol]; }
+
+    struct Stats {
+        usz lookups, hits, symbols;
+        // Arena chunks plus the hash table and symbol-to-text array.
+        usz bytes;
+
+        [[nodiscard]] double hit_rate() const { return lookups == 0 ? 0 : static_cast<double>(hits) / lookups; }
+    };
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    struct Slot {
+        u32 hash;
+        Symbol symbol;
+    };
+    static constexpr Symbol EMPTY_SLOT = UINT32_MAX;
+
+    const char *store(StrView);
+    void grow();
+
+    Vec<Slot> m_slots;
+    Vec<StrView> m_texts{};
+    Vec<Unique<char[]>> m_chunks{};
+    usz m_chunk_bytes{0};
+    char *m_cursor{nullptr};
+    usz m_remaining{0};
+    // Loaded and stored rather than incremented atomically: cheap on the lexing
+    // path, at the cost of counts lost to concurrent lookups.
+    std::atomic<usz> m_lookups{0}, m_hits{0};
+};
+
+// Shared by the tokenizer, parser and checker of a compilation.
+extern Interner interner;
@@ -1,14 +1,28 @@
 #include "Parser.hpp"
+#include "Tokenizer.hpp"
+#include "Trace.hpp"
+#include <charconv>
 #include <sstream>
 #include <iostream>
 
+// The name a top-level statement declares, if any.
+static Symbol declared_name(const ParsedStatement &stmt) {
+    if (auto *object = std::get_if<ParsedObject *>(&stmt.var)) return (*object)->id.value;
+    if (auto *interface = std::get_if<ParsedInterface *>(&stmt.var)) return (*interface)->id.value;
+    if (auto *fun = std::get_if<ParsedFunction *>(&stmt.var)) return (*fun)->id.value;
+    if (auto *var = std::get_if<ParsedVariable *>(&stmt.var)) return (*var)->id.value;
+    return Symbols::Empty;
+}
+
 ErrorOr<Vec<ParsedStatement *>> Parser::parse() {
     Vec<ParsedStatement *> stmts{};
-    while (m_pos < m_tokens.size() and not is(Token::Type::Eof)) {
+    while (not is(Token::Type::Eof)) {
         if (is(Token::Type::Newline)) { advance(); continue; }
+        TraceSpan span("parse_item");
         ParsedStatement *s = try$(stmt());
         if (s == nullptr)
             return error("check_statement is null, most likely a compiler bug.");
+        if (tracing()) span.set_detail(declared_name(*s));
         stmts.push_back(s);
     }
     return stmts;
@@ -28,16 +42,16 @@ ErrorOr<ParsedStatement *> Parser::stmt() {
 ErrorOr<ParsedStatement *> Parser::object() {
     try$(expect(Token::Type::Object));
     try$(expect(Token::Type::Id));
-    SpannedStr id = SpannedStr{previous().value.value(), previous().span};
+    SpannedSymbol id = identifier(previous());
 
-    Vec<Type *> generic_params = try$(generics());
+    Vec<TypeNodeId> generic_params = try$(generics());
 
-    Vec<SpannedStr> interfaces{};
+    Vec<SpannedSymbol> interfaces{};
     if (is(Token::Type::OpenParen)) {
         try$(expect(Token::Type::OpenParen));
-        while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
+        while (not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
             try$(expect(Token::Type::Id));
-            SpannedStr interface = SpannedStr{previous().value.value(), previous().span};
+            SpannedSymbol interface = identifier(previous());
             interfaces.push_back(interface);
 
             if (is(Token::Type::CloseParen)) break;
@@ -46,44 +60,45 @@ ErrorOr<ParsedStatement *> Parser::object() {
         try$(expect(Token::Type::CloseParen));
     }
 
-    Opt<SpannedStr> parent{};
+    Opt<SpannedSymbol> parent{};
     if (is(Token::Type::GreaterThan)) {
         try$(expect(Token::Type::GreaterThan));
         try$(expect(Token::Type::Id));
-        parent = std::make_optional(SpannedStr{previous().value.value(), previous().span});
+        parent = std::make_optional(identifier(previous()));
     }
 
     Vec<ParsedField> fields{};
     Vec<ParsedMethod> methods{};
     try$(expect(Token::Type::Colon));
     try$(expect(Token::Type::Indent));
-    while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::Dedent)) {
+    while (not is(Token::Type::Eof) and not is(Token::Type::Dedent)) {
         if (is(Token::Type::Fun) or is(Token::Type::Unsafe) or is(Token::Type::Static))
             methods.push_back(try$(method()));
         else fields.push_back(try$(field()));
 
-        while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and is(Token::Type::Newline))
+        while (not is(Token::Type::Eof) and is(Token::Type::Newline))
             advance();
     }
     if (is(Token::Type::Eof)) try$(expect(Token::Type::Eof));
     else if (is(Token::Type::Dedent)) try$(expect(Token::Type::Dedent));
 
-    auto *obj = new ParsedObject{id, generic_params, parent, interfaces, fields, methods};
+    auto *obj = m_ast.make<ParsedObject>(
+            id, std::move(generic_params), parent, std::move(interfaces), std::move(fields), std::move(methods));
     m_parsed_namespace.objects.push_back(obj);
-    return new ParsedStatement{ .var = obj };
+    return m_ast.make<ParsedStatement>(obj);
 }
 
 ErrorOr<ParsedStatement *> Parser::interface() {
     try$(expect(Token::Type::Interface));
     try$(expect(Token::Type::Id));
-    SpannedStr id = SpannedStr{previous().value.value(), previous().span};
+    SpannedSymbol id = identifier(previous());
 
-    Vec<SpannedStr> interfaces{};
+    Vec<SpannedSymbol> interfaces{};
     if (is(Token::Type::OpenParen)) {
         try$(expect(Token::Type::OpenParen));
-        while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
+        while (not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
             try$(expect(Token::Type::Id));
-            SpannedStr interface = SpannedStr{previous().value.value(), previous().span};
+            SpannedSymbol interface = identifier(previous());
             interfaces.push_back(interface);
 
             if (is(Token::Type::CloseParen)) break;
@@ -92,50 +107,39 @@ ErrorOr<ParsedStatement *> Parser::interface() {
         try$(expect(Token::Type::CloseParen));
     }
 
-    Block<ErrorOr<ParsedMethod>> raw_methods = try$(block<ErrorOr<ParsedMethod>>([&] { return method(); }));
-    Vec<ParsedMethod> methods{};
-    for (const auto& method : raw_methods.elems) {
-        methods.push_back(try$(method));
-    }
+    Block<ParsedMethod> methods = try$(block<ParsedMethod>([&] { return method(); }));
 
-    return new ParsedStatement{
-        .var = new ParsedInterface{
-            id,
-            interfaces,
-            methods,
-        }
-    };
+    return m_ast.make<ParsedStatement>(
+            m_ast.make<ParsedInterface>(id, std::move(interfaces), std::move(methods.elems)));
 }
 
 ErrorOr<ParsedStatement *> Parser::fun() {
     ParsedMethod m = try$(method());
 
-    return new ParsedStatement{
-        .var = new ParsedFunction{m.id, m.parameters, m.ret_type, m.body, m.unsafe}
-    };
+    return m_ast.make<ParsedStatement>(
+            m_ast.make<ParsedFunction>(m.id, std::move(m.parameters), m.ret_type, std::move(m.body), m.unsafe, m.deferred));
 }
 
 ErrorOr<ParsedStatement *> Parser::ret() {
-    Span span = try$(current()).span;
+    Span span = try$(current()).span();
     try$(expect(Token::Type::Return));
-    Opt<Expression *> value = std::make_optional(try$(expr()));
-    return new ParsedStatement{ .var = new ParsedReturn{span, value} };
+    Opt<ExprId> value = std::make_optional(try$(expr()));
+    return m_ast.make<ParsedStatement>(m_ast.make<ParsedReturn>(span, value));
 }
 
 ErrorOr<ParsedStatement *> Parser::var() {
-    Type *ty = try$(type());
+    TypeNodeId ty = try$(type());
     try$(expect(Token::Type::Id));
-    SpannedStr id = SpannedStr{previous().value.value(), previous().span};
+    SpannedSymbol id = identifier(previous());
     try$(expect(Token::Type::Equals));
-    Expression *ex = try$(expr());
-    return new ParsedStatement{ .var = new ParsedVariable{ty, id, ex} };
+    ExprId ex = try$(expr());
+    return m_ast.make<ParsedStatement>(m_ast.make<ParsedVariable>(ty, id, ex));
 }
 
-ErrorOr<Expression *> Parser::expr() { return binary(); }
-ErrorOr<Expression *> Parser::binary() {
+ErrorOr<ExprId> Parser::expr() { return binary(); }
+ErrorOr<ExprId> Parser::binary() {
     u8 precedence = try$(current()).precedence();
-    Expression *left = try$(unary());
-    if (left == nullptr) return error("expected an expression");
+    ExprId left = try$(unary());
     while (try$(current()).precedence() >= precedence and try$(current()).is_binary()) {
         Token op_token = advance();
         ExpressionDetails::Binary::Operation op;
@@ -146,13 +150,12 @@ ErrorOr<Expression *> Parser::binary() {
             default: return error("expected an operator but got `", Token::repr(op_token.type), "` instead");
         }
 
-        Expression *right = try$(unary());
-        if (right == nullptr) return error("expected an expression after `", Token::repr(op_token.type), "`");
-        left = new Expression{.var = new ExpressionDetails::Binary{op, left, right}};
+        ExprId right = try$(unary());
+        left = m_ast.add(ExpressionDetails::Binary{op, left, right});
     }
     return left;
 }
-ErrorOr<Expression *> Parser::unary() {
+ErrorOr<ExprId> Parser::unary() {
     if (is(Token::Type::Asterisk) or is(Token::Type::BitwiseAnd)) {
         Token op_token = advance();
 
@@ -161,180 +164,165 @@ ErrorOr<Expression *> Parser::unary() {
         else if (op_token.type == Token::Type::BitwiseAnd) op = ExpressionDetails::Unary::Operation::AddressOf;
         else return error("expected `*` or `&` but got `", Token::repr(op_token.type), "` instead");
 
-        Expression *right = try$(unary());
-        if (right == nullptr) return error("expected an expression after `", Token::repr(op_token.type), "`");
-        return new Expression{.var = new ExpressionDetails::Unary{op, right}};
+        ExprId right = try$(unary());
+        return m_ast.add(ExpressionDetails::Unary{op, right});
     }
     return primary();
 }
-ErrorOr<Expression *> Parser::primary() {
-    Expression *expression = nullptr;
+ErrorOr<ExprId> Parser::primary() {
+    Opt<ExprId> expression{};
     switch (try$(current()).type) {
         case Token::Type::Null: {
-            Span span = try$(current()).span;
+            Span span = try$(current()).span();
             try$(expect(Token::Type::Null));
-            expression = new Expression{.var = new ExpressionDetails::Null{span}};
+            expression = m_ast.add(ExpressionDetails::Null{span});
         } break;
         case Token::Type::Id: {
-            Span span = try$(current()).span;
-            Str value = try$(current()).value.value();
-            try$(expect(Token::Type::Id));
-            expression = new Expression{.var = new ExpressionDetails::Id{{value, span}}};
+            SpannedSymbol id = identifier(try$(expect(Token::Type::Id)));
+            expression = m_ast.add(ExpressionDetails::Id{id});
         } break;
         case Token::Type::Int: {
-            Span span = try$(current()).span;
-            int value = std::stoi(try$(current()).value.value());
-            try$(expect(Token::Type::Int));
-            expression = new Expression{.var = new ExpressionDetails::Int{{value, span}}};
+            Token token = try$(expect(Token::Type::Int));
+            int value = try$(integer(token));
+            expression = m_ast.add(ExpressionDetails::Int{{value, token.span()}});
         } break;
         case Token::Type::String: {
-            Span span = try$(current()).span;
-            Str value = try$(current()).value.value();
-            try$(expect(Token::Type::String));
-            expression = new Expression{.var = new ExpressionDetails::String{{value, span}}};
+            Token token = try$(expect(Token::Type::String));
+            Str value = unescape(token.text(m_source));
+            expression = m_ast.add(ExpressionDetails::String{{value, token.span()}});
         } break;
         case Token::Type::If: {
             try$(expect(Token::Type::If));
-            Expression *condition = try$(expr());
+            ExprId condition = try$(expr());
             try$(expect(Token::Type::Then));
-            Expression *then = try$(expr());
+            ExprId then = try$(expr());
             try$(expect(Token::Type::Else));
-            Expression *otherwise = try$(expr());
-            expression = new Expression{.var = new ExpressionDetails::If{condition, then, otherwise}};
+            ExprId otherwise = try$(expr());
+            expression = m_ast.add(ExpressionDetails::If{condition, then, otherwise});
         } break;
         case Token::Type::Switch: {
             try$(expect(Token::Type::Switch));
-            Expression *condition = try$(expr());
+            ExprId condition = try$(expr());
 
-            Block<ErrorOr<Pattern *>> raw_patterns = try$(block<ErrorOr<Pattern *>>([&] { return pattern(); }));
-            Vec<Pattern *> patterns{};
-            for (const auto& pattern : raw_patterns.elems) {
-                patterns.push_back(try$(pattern));
-            }
+            Block<Pattern *> patterns = try$(block<Pattern *>([&] { return pattern(); }));
 
         } break;
         case Token::Type::Unsafe: {
             try$(expect(Token::Type::Unsafe));
-            Block<ErrorOr<Expression *>> raw_body = try$(block<ErrorOr<Expression *>>([&] { return expr(); }));
-            Vec<Expression *> exprs{};
-            for (const auto& expr : raw_body.elems) {
-                exprs.push_back(try$(expr));
-            }
+            Block<ExprId> body = try$(block<ExprId>([&] { return expr(); }));
 
-            expression = new Expression{
-                .var = new ExpressionDetails::UnsafeBlock{exprs},
-            };
+            expression = m_ast.add(ExpressionDetails::UnsafeBlock{body.elems});
         } break;
         default:
             return error("expected an expression (such as an integer or a string) but got ", Token::repr(try$(current()).type), " instead");
     }
-    if (expression == nullptr)
+    if (not expression.has_value())
         return error("expected an expression (such as an integer or a string) but got ", Token::repr(try$(current()).type), " instead");
-    return postfix(expression);
+    return postfix(expression.value());
 }
 
-ErrorOr<Expression *> Parser::postfix(Expression *expression) {
+ErrorOr<ExprId> Parser::postfix(ExprId expression) {
     switch (try$(current()).type) {
         case Token::Type::OpenParen: {
-            Span span = previous().span;
+            Span span = previous().span();
             advance();
             Vec<Argument> args{};
-            while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
-                Opt<SpannedStr> id{};
+            while (not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
+                Opt<SpannedSymbol> id{};
                 if (is(Token::Type::Id)) {
                     try$(expect(Token::Type::Id));
-                    id = std::make_optional(SpannedStr{previous().value.value(), previous().span});
+                    id = std::make_optional(identifier(previous()));
                     try$(expect(Token::Type::Colon));
                 }
-                Expression *ex = try$(expr());
+                ExprId ex = try$(expr());
                 args.push_back({id, ex});
                 if (not is(Token::Type::CloseParen))
                     try$(expect(Token::Type::Comma));
             }
             try$(expect(Token::Type::CloseParen));
-            return postfix(new Expression{.var = new ExpressionDetails::Call{span, expression, {}, args}});
+            return postfix(m_ast.add(ExpressionDetails::Call{span, expression, {}, args}));
         }
         case Token::Type::OpenBracket: {
-            auto checkpoint = m_pos;
+            usz checkpoint = save();
             advance();
             auto index = expr();
             if (index.has_value()) {
+                drop();
                 try$(expect(Token::Type::CloseBracket));
-                return postfix(new Expression{.var = new ExpressionDetails::Index{expression, index.value()}});
+                return postfix(m_ast.add(ExpressionDetails::Index{expression, index.value()}));
             } else {
-                m_pos = checkpoint;
+                restore(checkpoint);
             }
 
             // In this case, it would be a generic function call or a generic type.
-            Vec<Type *> generic_args = try$(generics());
+            Vec<TypeNodeId> generic_args = try$(generics());
             if (is(Token::Type::OpenParen)) {
                 try$(expect(Token::Type::OpenParen));
                 Vec<Argument> args{};
-                while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
-                    Opt<SpannedStr> id{};
+                while (not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
+                    Opt<SpannedSymbol> id{};
                     if (is(Token::Type::Id)) {
                         try$(expect(Token::Type::Id));
-                        id = std::make_optional(SpannedStr{previous().value.value(), previous().span});
+                        id = std::make_optional(identifier(previous()));
                         try$(expect(Token::Type::Colon));
                     }
-                    Expression *ex = try$(expr());
+                    ExprId ex = try$(expr());
                     args.push_back({id, ex});
                     if (not is(Token::Type::CloseParen))
                         try$(expect(Token::Type::Comma));
                 }
                 try$(expect(Token::Type::CloseParen));
-                return postfix(new Expression{.var = new ExpressionDetails::Call{previous().span, expression, generic_args, args}});
+                return postfix(m_ast.add(ExpressionDetails::Call{previous().span(), expression, generic_args, args}));
             }
 
-            return postfix(new Expression{.var = new ExpressionDetails::GenericInstance{expression, generic_args}});
+            return postfix(m_ast.add(ExpressionDetails::GenericInstance{expression, generic_args}));
         }
         case Token::Type::Dot: {
             advance();
-            Expression *member = try$(primary());
-            if (member == nullptr) return error("expected an expression after `.`");
-            return postfix(new Expression{.var = new ExpressionDetails::Access{expression, member}});
+            ExprId member = try$(primary());
+            return postfix(m_ast.add(ExpressionDetails::Access{expression, member}));
         }
         default:
             return expression;
     }
 }
 
-ErrorOr<Type *> Parser::type() {
-    Type *ty = nullptr;
+ErrorOr<TypeNodeId> Parser::type() {
+    TypeNodeId ty{};
     switch (try$(current()).type) {
         case Token::Type::Id:
             advance();
-            ty = new Type{Type::Kind::Id, SpannedStr{previous().value.value(), previous().span}};
+            ty = m_ast.add(Type{Type::Kind::Id, identifier(previous())});
             if (is(Token::Type::OpenBracket)) {
-                Vec<Type *> generic_args = try$(generics());
-                ty = new Type{.type = Type::Kind::Generic, .id = ty->id, .generic_args = generic_args};
+                Vec<TypeNodeId> generic_args = try$(generics());
+                ty = m_ast.add(Type{.type = Type::Kind::Generic, .id = m_ast.type(ty).id, .generic_args = generic_args});
             }
             break;
         case Token::Type::StrType:
             advance();
-            ty = new Type{Type::Kind::Str};
+            ty = m_ast.add(Type{Type::Kind::Str});
             break;
         case Token::Type::IntType:
             advance();
-            ty = new Type{Type::Kind::Int};
+            ty = m_ast.add(Type{Type::Kind::Int});
             break;
         case Token::Type::OpenBracket: {
             try$(expect(Token::Type::OpenBracket));
-            Type *subtype = try$(type());
+            TypeNodeId subtype = try$(type());
             try$(expect(Token::Type::CloseBracket));
-            ty = new Type{.type = Type::Kind::Array, .subtype = subtype};
+            ty = m_ast.add(Type{.type = Type::Kind::Array, .subtype = subtype});
         }
             break;
         case Token::Type::Weak: {
             try$(expect(Token::Type::Weak));
-            Type *subtype = try$(type());
-            ty = new Type{.type = Type::Kind::Weak, .subtype = subtype};
+            TypeNodeId subtype = try$(type());
+            ty = m_ast.add(Type{.type = Type::Kind::Weak, .subtype = subtype});
         }
             break;
         case Token::Type::Raw: {
             try$(expect(Token::Type::Raw));
-            Type *subtype = try$(type());
-            ty = new Type{.type = Type::Kind::Raw, .subtype = subtype};
+            TypeNodeId subtype = try$(type());
+            ty = m_ast.add(Type{.type = Type::Kind::Raw, .subtype = subtype});
         }
             break;
         default:
@@ -344,25 +332,22 @@ ErrorOr<Type *> Parser::type() {
 
     if (is(Token::Type::Question)) {
         try$(expect(Token::Type::Question));
-        ty = new Type{.type = Type::Kind::Optional, .subtype = ty};
+        ty = m_ast.add(Type{.type = Type::Kind::Optional, .subtype = ty});
     }
 
     return ty;
 }
 
 ErrorOr<ParsedField> Parser::field() {
-    Type *ty = try$(type());
-    try$(expect(Token::Type::Id));
-    Span span = previous().span;
-    Str id = previous().value.value();
-    Opt<Expression *> value = {};
+    TypeNodeId ty = try$(type());
+    SpannedSymbol id = identifier(try$(expect(Token::Type::Id)));
+    Opt<ExprId> value = {};
     if (is(Token::Type::Equals)) {
         try$(expect(Token::Type::Equals));
-        Expression *e = try$(expr());
-        if (e == nullptr) return ParsedField{ty, id, {}};
+        ExprId e = try$(expr());
         value = std::make_optional(e);
     }
-    return ParsedField{ty, SpannedStr{id, span}, value};
+    return ParsedField{ty, id, value};
 }
 
 ErrorOr<ParsedMethod> Parser::method() {
@@ -378,44 +363,53 @@ ErrorOr<ParsedMethod> Parser::method() {
 
     try$(expect(Token::Type::Fun));
     try$(expect(Token::Type::Id));
-    SpannedStr id = SpannedStr{previous().value.value(), previous().span};
+    SpannedSymbol id = identifier(previous());
 
     Vec<ParsedField> parameters{};
     try$(expect(Token::Type::OpenParen));
-    while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
-        Type *ty = try$(type());
+    while (not is(Token::Type::Eof) and not is(Token::Type::CloseParen)) {
+        TypeNodeId ty = try$(type());
 
-        try$(expect(Token::Type::Id));
-        Str param = previous().value.value();
+        SpannedSymbol param = identifier(try$(expect(Token::Type::Id)));
 
         parameters.push_back({ty, param, {}});
     }
     try$(expect(Token::Type::CloseParen));
 
-    Opt<Type *> ret_type{};
+    Opt<TypeNodeId> ret_type{};
     if (is(Token::Type::GreaterThan)) {
         try$(expect(Token::Type::GreaterThan));
         ret_type = std::make_optional(try$(type()));
     }
 
     if (not is(Token::Type::Colon) and not is(Token::Type::Arrow))
-        return ParsedMethod{id, parameters, ret_type, Block{Vec<ParsedStatement *>()}, unsafe};
-
-    Block<ErrorOr<ParsedStatement *>> raw_body = try$(block<ErrorOr<ParsedStatement *>>([&] { return stmt(); }));
-    Vec<ParsedStatement *> stmts{};
-    for (const auto& stmt : raw_body.elems) {
-        stmts.push_back(try$(stmt));
+        return ParsedMethod{id, std::move(parameters), ret_type, Block{Vec<ParsedStatement *>()}, unsafe};
+
+    // Blocks end where their indentation does, so a body can be skipped
+    // without parsing it. Arrow bodies are a single expression and not worth it.
+    if (m_defer_bodies and is(Token::Type::Colon) and m_checkpoints.empty()) {
+        DeferredBody deferred{m_source, m_file_id, m_tokens[m_pos].offset, static_cast<u32>(m_tokens.indent())};
+        advance();
+        // Fails where `block()` would: on the first token that isn't the body's `Indent`.
+        if (Opt<Token> found = m_tokens.skip_block(m_pos); found.has_value()) {
+            Error missing = error(Token::Type::Indent, found->type);
+            missing.span = found->span();
+            return missing;
+        }
+        return ParsedMethod{id, std::move(parameters), ret_type, Block<ParsedStatement *>{}, unsafe, static_, deferred};
     }
 
-    return ParsedMethod{id, parameters, ret_type, Block{stmts}, unsafe, static_};
+    Block<ParsedStatement *> body = try$(block<ParsedStatement *>([&] { return stmt(); }));
+
+    return ParsedMethod{id, std::move(parameters), ret_type, std::move(body), unsafe, static_};
 }
 
-ErrorOr<Vec<Type *>> Parser::generics() {
-    Vec<Type *> params{};
+ErrorOr<Vec<TypeNodeId>> Parser::generics() {
+    Vec<TypeNodeId> params{};
     if (is(Token::Type::OpenBracket)) {
         try$(expect(Token::Type::OpenBracket));
-        while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::CloseBracket)) {
-            Type *ty = try$(type());
+        while (not is(Token::Type::Eof) and not is(Token::Type::CloseBracket)) {
+            TypeNodeId ty = try$(type());
             params.push_back(ty);
             if (is(Token::Type::CloseBracket)) break;
             try$(expect(Token::Type::Comma));
@@ -431,7 +425,7 @@ ErrorOr<Pattern *> Parser::pattern() {
         PatternCondition condition = try$(pattern_condition());
         if (is(Token::Type::Arrow)) {
             try$(expect(Token::Type::Arrow));
-            Expression *value = try$(expr());
+            ExprId value = try$(expr());
             if (is(Token::Type::Newline))
                 try$(expect(Token::Type::Newline));
         } else {
@@ -445,39 +439,99 @@ ErrorOr<Pattern *> Parser::pattern() {
 
 ErrorOr<PatternCondition> Parser::pattern_condition() { }
 
-template <typename T> ErrorOr<Block<T>> Parser::block(std::function<T()> fn) {
-    Vec<T> elems{};
+ErrorOr<Block<ParsedStatement *>> Parser::deferred_body(const DeferredBody &body) {
+    if (body.file_id != m_file_id) PANIC("deferred_body() on a body from another file");
+    m_tokens.seek(body.offset, body.indent);
+    m_pos = 0;
+    m_checkpoints.clear();
+    return block<ParsedStatement *>([&] { return stmt(); });
+}
+
+template <typename T, typename ParseElement>
+    requires std::is_invocable_r_v<ErrorOr<T>, ParseElement &>
+ErrorOr<Block<T>> Parser::block(ParseElement &&parse_element) {
+    Block<T> block{};
     if (is(Token::Type::Arrow)) {
         try$(expect(Token::Type::Arrow));
-        elems.push_back(try$(fn()));
-        return Block<T>{elems};
+        block.elems.push_back(try$(parse_element()));
+        return block;
     }
     try$(expect(Token::Type::Colon));
-    while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and is(Token::Type::Newline)) advance();
+    while (not is(Token::Type::Eof) and is(Token::Type::Newline)) advance();
     try$(expect(Token::Type::Indent));
-    while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and not is(Token::Type::Dedent)) {
-        elems.push_back(try$(fn()));
-        while (m_pos < m_tokens.size() and not is(Token::Type::Eof) and is(Token::Type::Newline))
+    while (not is(Token::Type::Eof) and not is(Token::Type::Dedent)) {
+        block.elems.push_back(try$(parse_element()));
+        while (not is(Token::Type::Eof) and is(Token::Type::Newline))
             advance();
     }
     if (is(Token::Type::Eof)) try$(expect(Token::Type::Eof));
     else if (is(Token::Type::Dedent)) try$(expect(Token::Type::Dedent));
-    return Block<T>{elems};
+    return block;
 }
 
 ErrorOr<Token> Parser::current() {
-    if (m_pos >= m_tokens.size())
+    if (m_pos > 0 and m_tokens.type(m_pos - 1) == Token::Type::Eof)
         return error("unexpected end of file");
     return m_tokens[m_pos];
 }
-Token Parser::previous() const { return m_tokens[m_pos - 1]; }
-bool Parser::is(Token::Type type) { return m_pos < m_tokens.size() and current().value().type == type; }
-Token Parser::advance() { return m_tokens[m_pos++]; }
+Token Parser::previous() { return m_tokens[m_pos - 1]; }
+bool Parser::is(Token::Type type) { return m_tokens.type(m_pos) == type; }
+Token Parser::advance() {
+    Token token = m_tokens[m_pos++];
+    m_tokens.release(m_checkpoints.empty() ? m_pos - 1 : std::min(m_pos - 1, m_checkpoints.front()));
+    return token;
+}
+
+usz Parser::save() {
+    m_checkpoints.push_back(m_pos);
+    return m_pos;
+}
+void Parser::restore(usz checkpoint) {
+    m_pos = checkpoint;
+    m_checkpoints.pop_back();
+}
+void Parser::drop() { m_checkpoints.pop_back(); }
 ErrorOr<Token> Parser::expect(Token::Type type) {
     if (!is(type)) return error(type, try$(current()).type);
     return advance();
 }
 
+SpannedSymbol Parser::identifier(const Token &token) const {
+    return SpannedSymbol{token.symbol, token.span()};
+}
+
+ErrorOr<int> Parser::integer(const Token &token) const {
+    StrView text = token.text(m_source);
+    int base = 10;
+    if (text.starts_with("0x")) base = 16;
+    else if (text.starts_with("0b")) base = 2;
+    if (base != 10) text.remove_prefix(2);
+    // The tokenizer ends `0x` and `0b` at the first character that is not a
+    // digit of their base, so they may have none.
+    if (text.empty())
+        return Error{Str("expected digits after `") + (base == 16 ? "0x" : "0b") + "`", token.span()};
+
+    // Digit separators (`1_000_000`) are not part of the value, but each must
+    // be followed by a digit.
+    char digits[64];
+    usz length = 0;
+    for (usz i = 0; i < text.size(); i++) {
+        if (text[i] == '_') {
+            if (i + 1 == text.size() or text[i + 1] == '_')
+                return Error{"expected a digit after `_` in integer literal", token.span()};
+            continue;
+        }
+        if (length == sizeof(digits)) return Error{"integer literal is too long", token.span()};
+        digits[length++] = text[i];
+    }
+
+    int value = 0;
+    auto [end, ec] = std::from_chars(digits, digits + length, value, base);
+    if (ec != std::errc{} or end != digits + length)
+        return Error{"integer literal is out of range", token.span()};
+    return value;
+}
+
 Error Parser::error(Token::Type expects, Token::Type got) {
     return error("expected `", Token::repr(expects), "`, but got `", Token::repr(got),
           "` instead");
@@ -485,5 +539,5 @@ Error Parser::error(Token::Type expects, Token::Type got) {
 template <typename... Args> Error Parser::error(Args... args) {
     std::stringstream ss;
     (ss << ... << args);
-    return {ss.str(), (m_pos < m_tokens.size() ? m_tokens[m_pos] : m_tokens[m_pos - 1]).span };
+    return {ss.str(), m_tokens[m_pos].span()};
 }
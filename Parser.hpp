@@ -3,15 +3,25 @@
 #include "Ast.hpp"
 #include "Common.hpp"
 #include "Token.hpp"
-#include <functional>
+#include "Tokenizer.hpp"
+#include <type_traits>
 #include <utility>
 
 class Parser {
   public:
-    explicit Parser(Vec<Token> tokens) : m_tokens(std::move(tokens)), m_errors({}), m_pos(0) {}
+    // With `defer_bodies`, method and function bodies are skipped and left
+    // for `deferred_body()`, so only declarations and signatures are parsed.
+    Parser(Tokenizer &tokenizer, Ast &ast, bool defer_bodies = false)
+            : m_ast(ast), m_tokens(tokenizer), m_source(tokenizer.source()), m_errors({}), m_pos(0),
+              m_file_id(tokenizer.file_id()), m_defer_bodies(defer_bodies) {}
 
     ErrorOr<Vec<ParsedStatement *>> parse();
 
+    // Parses a body skipped by a parser over the same file, moving this
+    // parser's tokenizer there. Lexical errors in it were already reported
+    // by the tokenizer that skipped it.
+    ErrorOr<Block<ParsedStatement *>> deferred_body(const DeferredBody &);
+
     ErrorOr<ParsedStatement *> stmt();
     ErrorOr<ParsedStatement *> object();
     ErrorOr<ParsedStatement *> interface();
@@ -19,41 +29,62 @@ class Parser {
     ErrorOr<ParsedStatement *> ret();
     ErrorOr<ParsedStatement *> var();
 
-    ErrorOr<Expression *> expr();
-    ErrorOr<Expression *> binary();
-    ErrorOr<Expression *> unary();
-    ErrorOr<Expression *> primary();
-    ErrorOr<Expression *> postfix(Expression *);
+    ErrorOr<ExprId> expr();
+    ErrorOr<ExprId> binary();
+    ErrorOr<ExprId> unary();
+    ErrorOr<ExprId> primary();
+    ErrorOr<ExprId> postfix(ExprId);
 
-    ErrorOr<Type *> type();
+    ErrorOr<TypeNodeId> type();
 
     ErrorOr<ParsedField> field();
     ErrorOr<ParsedMethod> method();
-    ErrorOr<Vec<Type *>> generics();
+    ErrorOr<Vec<TypeNodeId>> generics();
 
     ErrorOr<Pattern *> pattern();
     ErrorOr<PatternCondition> pattern_condition();
 
-    template <typename T> ErrorOr<Block<T>> block(Fn<T()>);
+    // Parses `-> element` or an indented block of elements. The callable is a
+    // template parameter rather than a `Fn`, so it inlines into the loop.
+    template <typename T, typename ParseElement>
+        requires std::is_invocable_r_v<ErrorOr<T>, ParseElement &>
+    ErrorOr<Block<T>> block(ParseElement &&parse_element);
 
     [[nodiscard]] ErrorOr<Token> current();
-    [[nodiscard]] Token previous() const;
+    [[nodiscard]] Token previous();
     [[nodiscard]] bool is(Token::Type);
     Token advance();
     ErrorOr<Token> expect(Token::Type);
 
+    [[nodiscard]] SpannedSymbol identifier(const Token &) const;
+    // The value of an `Int` token: decimal with `_` separators, or hex after
+    // `0x` and binary after `0b`, as the tokenizer lexes them. It must fit in
+    // an `int`.
+    [[nodiscard]] ErrorOr<int> integer(const Token &) const;
+
     Error error(Token::Type, Token::Type);
     template <typename... Args> Error error(Args...);
 
-    [[nodiscard]] ParsedNamespace parsed_namespace() const { return m_parsed_namespace; }
-    [[nodiscard]] Vec<Token> tokens() const { return m_tokens; }
-    [[nodiscard]] Vec<Error> errors() const { return m_errors; }
+    [[nodiscard]] const ParsedNamespace &parsed_namespace() const { return m_parsed_namespace; }
+    [[nodiscard]] const Vec<Error> &errors() const { return m_errors; }
     [[nodiscard]] usz pos() const { return m_pos; }
 
   private:
+    // Backtracking: tokens from the oldest live checkpoint on stay buffered
+    // until it is restored or dropped.
+    usz save();
+    void restore(usz checkpoint);
+    void drop();
+
     ParsedNamespace m_parsed_namespace{};
 
-    Vec<Token> m_tokens;
+    Ast &m_ast;
+
+    TokenBuffer m_tokens;
+    StrView m_source;
+    Vec<usz> m_checkpoints{};
     Vec<Error> m_errors;
     usz m_pos{0};
+    FileId m_file_id;
+    bool m_defer_bodies;
 };
\ No newline at end of file
@@ -1,159 +1,375 @@
 #include "Project.hpp"
+#include "Parser.hpp"
+#include "Tokenizer.hpp"
+#include "TypeInference.hpp"
 #include <format>
 
 bool Scope::can_access(ScopeId own, ScopeId other, const Project &project) {
     if (own == other) return true;
     else {
-        auto own_scope = project.scopes[own];
-        while (own_scope->parent.has_value()) {
-            auto parent = own_scope->parent.value();
+        const Scope *own_scope = &project.scopes[own];
+        while (own_scope->parent().has_value()) {
+            auto parent = own_scope->parent().value();
             if (parent == other)
                 return true;
-            own_scope = project.scopes[parent];
+            own_scope = &project.scopes[parent];
         }
         return false;
     }
 }
 
-TypeId Project::find_or_add_type_id(const CheckedType& type) {
-    for (usz i = 0; i < this->types.size(); i++) {
-        auto ty = this->types[i];
-        if (ty == type) { return i; }
+static constexpr TypeId EMPTY_TYPE_SLOT = SIZE_MAX;
+
+static usz hash_type(const CheckedType &type) {
+    constexpr usz multiplier = 0x9E3779B97F4A7C15ull;
+    usz hash = static_cast<usz>(type.tag) * multiplier;
+    auto mix = [&](usz value) { hash = (hash ^ value) * multiplier; };
+    switch (type.tag) {
+        case CheckedType::Tag::Builtin: break;
+        case CheckedType::Tag::TypeVariable: mix(type.type_variable.variable); break;
+        case CheckedType::Tag::GenericInstance:
+            mix(type.generic_instance.record_id);
+            for (TypeId argument : type.generic_instance.generic_arguments) mix(argument);
+            break;
+        case CheckedType::Tag::Record: mix(type.record.record_id); break;
+        case CheckedType::Tag::RawPtr: mix(type.rawptr.subtype); break;
+        case CheckedType::Tag::Inference: mix(static_cast<usz>(type.inference.owner) << 32 | type.inference.variable); break;
     }
+    return hash ^ (hash >> 32);
+}
+
+Project::Project(const Ast &ast, usz jobs) : m_ast(ast), m_pool(jobs) {
+    for (usz i = 0; i < m_pool.size(); i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+        m_workers.back()->inference = std::make_unique<TypeInference>(i);
+    }
+    for (TypeShard &shard : m_type_shards) shard.table.assign(16, EMPTY_TYPE_SLOT);
+
+    this->scopes.append();
 
-    this->types.push_back(type);
-    return this->types.size() - 1;
+    for (TypeId id = UNKNOWN_TYPE_ID; id <= STRING_TYPE_ID; id++)
+        this->types.append(CheckedType::Builtin());
+
+#define X(id, name, parameter) add_prelude_record(Symbols::name, Symbols::parameter);
+    PRELUDE_RECORDS
+#undef X
 }
 
-ScopeId Project::create_scope(ScopeId scope) {
-    this->scopes.push_back(new Scope(std::make_optional(scope)));
-    return this->scopes.size() - 1;
+void Project::add_prelude_record(Symbol name, Symbol type_parameter) {
+    RecordId record_id = this->records.size();
+    ScopeId scope_id = create_scope(0);
+
+    TypeId parameter_type_id = find_or_add_type_id(CheckedType::TypeVariable(type_parameter));
+    (void) add_type_to_scope(scope_id, type_parameter, parameter_type_id, Span{});
+
+    this->records.push_back(CheckedRecord{
+            .name = name,
+            .generic_parameters = {parameter_type_id},
+            .fields = {},
+            .scope_id = scope_id,
+    });
+    (void) add_type_to_scope(0, name, find_or_add_type_id(CheckedType::Record(record_id)), Span{});
+    (void) add_record_to_scope(0, name, record_id, Span{});
 }
 
-ErrorOr<Void> Project::add_var_to_scope(ScopeId scope_id, const CheckedVariable& var, Span span) {
-    Scope *scope = this->scopes[scope_id];
-    for (const auto& existing_var : scope->types) {
-        if (var.name == existing_var.id) {
-            return Error(
-                std::format("redefinition of variable {}", var.name),
-                span
-            );
-        }
+Project::~Project() = default;
+
+TypeId Project::find_or_add_type_id(const CheckedType& type) {
+    usz hash = hash_type(type);
+    TypeShard &shard = m_type_shards[hash % TYPE_SHARDS];
+    std::unique_lock lock(shard.mutex, std::defer_lock);
+    if (m_pool.size() > 1) lock.lock();
+
+    usz mask = shard.table.size() - 1;
+    usz i = (hash / TYPE_SHARDS) & mask;
+    for (; shard.table[i] != EMPTY_TYPE_SLOT; i = (i + 1) & mask) {
+        if (this->types[shard.table[i]] == type) return shard.table[i];
     }
 
-    scope->variables.push_back(var);
-    return Void{};
+    TypeId id = this->types.append(type);
+    shard.table[i] = id;
+    // Keep the table at most half full.
+    if (++shard.count * 2 > shard.table.size()) grow_type_shard(shard);
+    return id;
+}
+
+void Project::grow_type_shard(TypeShard &shard) {
+    Vec<TypeId> table(shard.table.size() * 2, EMPTY_TYPE_SLOT);
+    usz mask = table.size() - 1;
+    for (TypeId id : shard.table) {
+        if (id == EMPTY_TYPE_SLOT) continue;
+        usz i = (hash_type(this->types[id]) / TYPE_SHARDS) & mask;
+        while (table[i] != EMPTY_TYPE_SLOT) i = (i + 1) & mask;
+        table[i] = id;
+    }
+    shard.table = std::move(table);
+}
+
+ScopeId Project::create_scope(ScopeId scope) {
+    ScopeId id = this->scopes.append(std::make_optional(scope));
+    if (id >= NO_SCOPE) PANIC("too many scopes");
+    return id;
 }
 
-Opt<CheckedVariable> Project::find_var_in_scope(ScopeId id, const Str& var) {
-    Opt<ScopeId> scope_id = std::make_optional(id);
+void Project::parallel_for(usz count, const Fn<void(usz)> &task) {
+    // Names added since a thread last ran may be missing from its cache, and
+    // the names added by the tasks from everybody else's.
+    invalidate_resolved();
+    m_pool.parallel_for(count, task);
+    invalidate_resolved();
+}
 
-    while (scope_id.has_value()) {
-        ScopeId current_id = scope_id.value();
-        Scope *scope = this->scopes[current_id];
+static usz hash_substitution(const Map<TypeId, TypeId> &substitution) {
+    usz hash = substitution.size();
+    for (auto [from, to] : substitution) hash = (hash ^ (from << 32 | to)) * 0x9E3779B97F4A7C15ull;
+    return hash ^ hash >> 29;
+}
 
-        for (auto v : scope->variables) {
-            if (v.name == var) return std::make_optional(v);
-        }
+Opt<Block<ParsedStatement *>> Project::parse_deferred_body(const DeferredBody &body) {
+    Worker &worker = this->worker();
+    if (worker.body_ast == nullptr) worker.body_ast = std::make_unique<Ast>();
+    if (worker.body_parser == nullptr or worker.body_tokenizer->file_id() != body.file_id) {
+        worker.body_parser.reset();
+        worker.body_tokenizer = std::make_unique<Tokenizer>(body.file_id, body.source);
+        worker.body_parser = std::make_unique<Parser>(*worker.body_tokenizer, *worker.body_ast);
+    }
 
-        scope_id = scope->parent;
+    usz lexical_errors = worker.body_tokenizer->errors().size();
+    ErrorOr<Block<ParsedStatement *>> parsed = worker.body_parser->deferred_body(body);
+    const Vec<Error> &errors = worker.body_tokenizer->errors();
+    worker.syntax_errors.insert(worker.syntax_errors.end(), errors.begin() + lexical_errors, errors.end());
+    if (not parsed.has_value()) {
+        worker.syntax_errors.push_back(std::move(parsed).error());
+        return std::nullopt;
     }
+    if (errors.size() > lexical_errors) return std::nullopt;
+    return std::move(parsed).value();
+}
 
-    return std::nullopt;
+Opt<Error> Project::first_syntax_error() const {
+    Opt<Error> first = std::nullopt;
+    for (const auto &worker : m_workers) {
+        for (const Error &error : worker->syntax_errors) {
+            if (not first.has_value() or std::pair(error.span.file_id, error.span.offset) <
+                                                 std::pair(first->span.file_id, first->span.offset))
+                first = error;
+        }
+    }
+    return first;
 }
 
-ErrorOr<Void> Project::add_type_to_scope(ScopeId scope_id, Str type_name, TypeId type_id, Span span) {
-    Scope *scope = this->scopes[scope_id];
-    for (const auto& existing_type : scope->types) {
-        if (type_name == existing_type.id) {
-            return Error(
-                    std::format("redefinition of variable {}", type_name),
-                    span
-            );
+SubstitutionId Project::find_or_add_substitution(const Map<TypeId, TypeId> &substitution) {
+    if (substitution.empty()) return 0;
+
+    Worker &worker = this->worker();
+    usz hash = hash_substitution(substitution);
+    usz mask = worker.substitution_ids.size() - 1;
+    usz i = hash & mask;
+    for (; worker.substitution_ids[i].id != 0; i = (i + 1) & mask) {
+        const InternedSubstitution &interned = worker.substitution_ids[i];
+        if (interned.hash == hash and interned.size == substitution.size() and
+            std::equal(substitution.begin(), substitution.end(), worker.substitution_pairs.begin() + interned.begin,
+                       [](const auto &a, const auto &b) { return a.first == b.first and a.second == b.second; }))
+            return interned.id;
+    }
+
+    InternedSubstitution interned{hash, static_cast<u32>(worker.substitution_pairs.size()),
+                                  static_cast<u32>(substitution.size()),
+                                  static_cast<SubstitutionId>(worker.substitution_count + 1)};
+    worker.substitution_pairs.insert(worker.substitution_pairs.end(), substitution.begin(), substitution.end());
+    worker.substitution_ids[i] = interned;
+    worker.substitution_count++;
+
+    if (worker.substitution_count * 2 > worker.substitution_ids.size()) {
+        Vec<InternedSubstitution> table(worker.substitution_ids.size() * 2);
+        mask = table.size() - 1;
+        for (const InternedSubstitution &entry : worker.substitution_ids) {
+            if (entry.id == 0) continue;
+            usz j = entry.hash & mask;
+            while (table[j].id != 0) j = (j + 1) & mask;
+            table[j] = entry;
         }
+        worker.substitution_ids = std::move(table);
     }
+    return interned.id;
+}
 
-    scope->types.push_back({type_name, type_id});
-    return Void{};
+static usz substituted_key(TypeId type_id, SubstitutionId substitution) {
+    return type_id << 32 | substitution;
 }
 
-Opt<TypeId> Project::find_type_in_scope(ScopeId id, const Str &type) {
-    Opt<ScopeId> scope_id = std::make_optional(id);
+static usz substituted_slot(usz key, usz mask) {
+    key *= 0x9E3779B97F4A7C15ull;
+    return (key ^ key >> 32) & mask;
+}
 
-    while (scope_id.has_value()) {
-        ScopeId current_id = scope_id.value();
-        Scope *scope = this->scopes[current_id];
+Opt<TypeId> Project::find_substituted_type(TypeId type_id, SubstitutionId substitution) {
+    Worker &worker = this->worker();
+    worker.substitution_stats.lookups++;
 
-        for (auto v : scope->types) {
-            if (v.id == type) return std::make_optional(v.value);
+    usz key = substituted_key(type_id, substitution);
+    usz mask = worker.substituted.size() - 1;
+    for (usz i = substituted_slot(key, mask); worker.substituted[i].key != SIZE_MAX; i = (i + 1) & mask) {
+        if (worker.substituted[i].key == key) {
+            worker.substitution_stats.hits++;
+            return worker.substituted[i].result;
         }
-
-        scope_id = scope->parent;
     }
-
     return std::nullopt;
 }
 
-ErrorOr<Void> Project::add_function_to_scope(ScopeId scope_id, Str name, FunctionId function_id, Span span) {
-    Scope *scope = this->scopes[scope_id];
-    for (const auto& fn : scope->functions) {
-        if (name == fn.id) {
-            return Error(
-                    std::format("redefinition of function {}", name),
-                    span
-            );
+void Project::add_substituted_type(TypeId type_id, SubstitutionId substitution, TypeId result) {
+    Worker &worker = this->worker();
+    if ((worker.substituted_count + 1) * 2 > worker.substituted.size()) {
+        Vec<SubstitutedType> table(worker.substituted.size() * 2);
+        usz mask = table.size() - 1;
+        for (const SubstitutedType &entry : worker.substituted) {
+            if (entry.key == SIZE_MAX) continue;
+            usz i = substituted_slot(entry.key, mask);
+            while (table[i].key != SIZE_MAX) i = (i + 1) & mask;
+            table[i] = entry;
         }
+        worker.substituted = std::move(table);
     }
 
-    scope->functions.push_back({name, function_id});
-    return Void{};
+    usz key = substituted_key(type_id, substitution);
+    usz mask = worker.substituted.size() - 1;
+    usz i = substituted_slot(key, mask);
+    for (; worker.substituted[i].key != SIZE_MAX; i = (i + 1) & mask) {
+        if (worker.substituted[i].key == key) {
+            worker.substituted[i].result = result;
+            return;
+        }
+    }
+    worker.substituted[i] = SubstitutedType{key, result};
+    worker.substituted_count++;
 }
 
-Opt<FunctionId> Project::find_function_in_scope(ScopeId id, const Str &name) {
-    Opt<ScopeId> scope_id = std::make_optional(id);
+Project::CacheStats Project::substitution_stats() const {
+    CacheStats stats{0, 0};
+    for (const auto &worker : m_workers) {
+        stats.lookups += worker->substitution_stats.lookups;
+        stats.hits += worker->substitution_stats.hits;
+    }
+    return stats;
+}
 
-    while (scope_id.has_value()) {
-        ScopeId current_id = scope_id.value();
-        Scope *scope = this->scopes[current_id];
+Project::Stats Project::stats() const {
+    usz checked_bytes = 0;
+    for (const auto &worker : m_workers) checked_bytes += worker->checked.used();
+    return Stats{
+            .types = types.size(),
+            .scopes = scopes.size(),
+            .functions = functions.size(),
+            .records = records.size(),
+            .checked_bytes = checked_bytes,
+            .substitutions = substitution_stats(),
+    };
+}
+
+void Project::invalidate_resolved() {
+    for (auto &worker : m_workers)
+        for (u32 &generation : worker->generations) generation++;
+}
 
-        for (auto v : scope->functions) {
-            if (v.id == name) return std::make_optional(v.value);
+void Project::add_child_scope(ScopeId parent, ScopeId child) {
+    this->scopes[child].next_sibling = this->scopes[parent].first_child;
+    this->scopes[parent].first_child = static_cast<u32>(child);
+}
+
+Opt<usz> Project::resolve(ScopeId id, Symbol name, SymbolKind kind) {
+    Worker &worker = this->worker();
+    u32 generation = worker.generations[static_cast<usz>(kind)];
+    u32 name_generation = kind == SymbolKind::Variable and name < worker.variable_generations.size()
+            ? worker.variable_generations[name]
+            : 0;
+    usz hash = (id * 0x9E3779B97F4A7C15ull) ^ (static_cast<usz>(name) << 2 | static_cast<usz>(kind));
+    ResolvedName &cached = worker.resolved[(hash ^ hash >> 29) & (worker.resolved.size() - 1)];
+    if (cached.scope_id == id and cached.name == name and cached.kind == kind and cached.generation == generation
+        and cached.name_generation == name_generation)
+        return cached.found ? std::make_optional(cached.value) : std::nullopt;
+
+    Opt<usz> result = std::nullopt;
+    u32 scope_id = static_cast<u32>(id);
+    while (scope_id != NO_SCOPE) {
+        const Scope &scope = this->scopes[scope_id];
+        if (const usz *value = scope.symbols.find(name, kind)) {
+            result = *value;
+            break;
         }
+        scope_id = scope.parent_id;
+    }
+
+    cached = ResolvedName{id, name, kind, result.has_value(), generation, name_generation, result.value_or(0)};
+    return result;
+}
 
-        scope_id = scope->parent;
+ErrorOr<Void> Project::add_var_to_scope(ScopeId scope_id, const CheckedVariable& var, Span span) {
+    if (not this->scopes[scope_id].symbols.insert(var.name, SymbolKind::Variable, var.type_id)) {
+        return Error(
+            std::format("redefinition of variable {}", interner.text(var.name)),
+            span
+        );
     }
 
-    return std::nullopt;
+    // A binding can only change what its own name resolves to, so the cached
+    // lookups of every other name stay valid.
+    Vec<u32> &generations = this->worker().variable_generations;
+    if (var.name >= generations.size()) generations.resize(std::max<usz>(var.name + 1, generations.size() * 2));
+    generations[var.name]++;
+    return Void{};
 }
 
-ErrorOr<Void> Project::add_record_to_scope(ScopeId scope_id, Str name, RecordId record_id, Span span) {
-    Scope *scope = this->scopes[scope_id];
-    for (const auto& record : scope->records) {
-        if (name == record.id) {
-            return Error(
-                    std::format("redefinition of record {}", name),
-                    span
-            );
-        }
+Opt<CheckedVariable> Project::find_var_in_scope(ScopeId id, Symbol var) {
+    Opt<TypeId> type_id = resolve(id, var, SymbolKind::Variable);
+    if (not type_id.has_value()) return std::nullopt;
+    return CheckedVariable{var, type_id.value()};
+}
+
+ErrorOr<Void> Project::add_type_to_scope(ScopeId scope_id, Symbol type_name, TypeId type_id, Span span) {
+    if (not this->scopes[scope_id].symbols.insert(type_name, SymbolKind::Type, type_id)) {
+        return Error(
+                std::format("redefinition of variable {}", interner.text(type_name)),
+                span
+        );
     }
 
-    scope->records.push_back({name, record_id});
+    worker().generations[static_cast<usz>(SymbolKind::Type)]++;
     return Void{};
 }
 
-Opt<RecordId> Project::find_record_in_scope(ScopeId id, const Str &record_name) {
-    Opt<ScopeId> scope_id = std::make_optional(id);
+Opt<TypeId> Project::find_type_in_scope(ScopeId id, Symbol type) {
+    return resolve(id, type, SymbolKind::Type);
+}
 
-    while (scope_id.has_value()) {
-        ScopeId current_id = scope_id.value();
-        Scope *scope = this->scopes[current_id];
+ErrorOr<Void> Project::add_function_to_scope(ScopeId scope_id, Symbol name, FunctionId function_id, Span span) {
+    if (not this->scopes[scope_id].symbols.insert(name, SymbolKind::Function, function_id)) {
+        return Error(
+                std::format("redefinition of function {}", interner.text(name)),
+                span
+        );
+    }
 
-        for (auto v : scope->records) {
-            if (v.id == record_name) return std::make_optional(v.value);
-        }
+    worker().generations[static_cast<usz>(SymbolKind::Function)]++;
+    return Void{};
+}
+
+Opt<FunctionId> Project::find_function_in_scope(ScopeId id, Symbol name) {
+    return resolve(id, name, SymbolKind::Function);
+}
 
-        scope_id = scope->parent;
+ErrorOr<Void> Project::add_record_to_scope(ScopeId scope_id, Symbol name, RecordId record_id, Span span) {
+    if (not this->scopes[scope_id].symbols.insert(name, SymbolKind::Record, record_id)) {
+        return Error(
+                std::format("redefinition of record {}", interner.text(name)),
+                span
+        );
     }
 
-    return std::nullopt;
+    worker().generations[static_cast<usz>(SymbolKind::Record)]++;
+    return Void{};
+}
+
+Opt<RecordId> Project::find_record_in_scope(ScopeId id, Symbol record_name) {
+    return resolve(id, record_name, SymbolKind::Record);
 }
@@ -1,9 +1,18 @@
 #pragma once
 
 #include "Common.hpp"
+#include "Arena.hpp"
 #include "Ast.hpp"
+#include "ChunkedVec.hpp"
+#include "Interner.hpp"
+#include "SymbolTable.hpp"
+#include "ThreadPool.hpp"
+#include <mutex>
 
+class Parser;
 class Project;
+class Tokenizer;
+class TypeInference;
 
 enum : usz {
     UNKNOWN_TYPE_ID = 0,
@@ -17,23 +26,43 @@ enum : usz {
 
 using RecordId = usz;
 using FunctionId = usz;
+
+// Records every program can use, as `X(id, name, type parameter)`. `Project`
+// registers them in the global scope before anything else, so their ids are
+// fixed, and builds them from this table: there is no source to parse or
+// check for them at startup.
+#define PRELUDE_RECORDS                                                        \
+    X(ARRAY_RECORD_ID, Array, T)                                               \
+    X(OPTIONAL_RECORD_ID, Optional, T)                                         \
+    X(WEAK_PTR_RECORD_ID, WeakPtr, T)
+
+enum : RecordId {
+#define X(id, name, parameter) id,
+    PRELUDE_RECORDS
+#undef X
+    PRELUDE_RECORD_COUNT
+};
 using ScopeId = usz;
 using TypeId = usz;
+// An interned mapping from type variables to types; 0 is the empty one.
+using SubstitutionId = u32;
 
 enum class SafetyContext { Safe, Unsafe };
 
 struct CheckedType {
-    enum class Tag { Builtin, TypeVariable, GenericInstance, Record, RawPtr };
+    enum class Tag { Builtin, TypeVariable, GenericInstance, Record, RawPtr, Inference };
 
     Tag tag{};
-    struct { Str variable; } type_variable;
+    struct { Symbol variable; } type_variable;
     struct { RecordId record_id; Vec<TypeId> generic_arguments; } generic_instance;
     struct { RecordId record_id; } record{};
     struct { TypeId subtype; } rawptr{};
+    // A not yet known type being solved for by the `TypeInference` of worker `owner`.
+    struct { u32 owner, variable; } inference{};
 
     static CheckedType Builtin() { return CheckedType{Tag::Builtin}; }
 
-    static CheckedType TypeVariable(Str var) {
+    static CheckedType TypeVariable(Symbol var) {
         return CheckedType{.tag = Tag::TypeVariable, .type_variable = {var}};
     }
 
@@ -49,23 +78,41 @@ struct CheckedType {
         return CheckedType{.tag = Tag::RawPtr, .rawptr = {subtype}};
     }
 
-    bool operator==(const CheckedType& other) const { return this->tag == other.tag; }
-    bool operator!=(const CheckedType& other) const { return this->tag != other.tag; }
+    static CheckedType Inference(u32 owner, u32 variable) {
+        return CheckedType{.tag = Tag::Inference, .inference = {owner, variable}};
+    }
+
+    bool operator==(const CheckedType& other) const {
+        if (tag != other.tag) return false;
+        switch (tag) {
+            case Tag::Builtin: return true;
+            case Tag::TypeVariable: return type_variable.variable == other.type_variable.variable;
+            case Tag::GenericInstance:
+                return generic_instance.record_id == other.generic_instance.record_id and
+                       generic_instance.generic_arguments == other.generic_instance.generic_arguments;
+            case Tag::Record: return record.record_id == other.record.record_id;
+            case Tag::RawPtr: return rawptr.subtype == other.rawptr.subtype;
+            case Tag::Inference:
+                return inference.owner == other.inference.owner and inference.variable == other.inference.variable;
+        }
+        return false;
+    }
+    bool operator!=(const CheckedType& other) const { return not (*this == other); }
 };
 
 struct CheckedVarDecl {
-    Str name;
+    Symbol name;
     TypeId type_id;
     Span span;
 };
 
 struct CheckedVariable {
-    Str name;
+    Symbol name;
     TypeId type_id;
 };
 
 struct CheckedRecord {
-    Str name;
+    Symbol name;
     Vec<TypeId> generic_parameters;
     Vec<CheckedVarDecl> fields;
     ScopeId scope_id;
@@ -78,12 +125,14 @@ struct CheckedParameter {
 
 struct CheckedStatement;
 
+// Statements and expressions of checked function bodies live in the
+// arena of the thread that checked them, for as long as the `Project`.
 struct CheckedBlock {
-    Vec<CheckedStatement *> statements;
+    Slice<CheckedStatement *const> statements;
 };
 
 struct CheckedFunction {
-    Str name;
+    Symbol name;
     // TODO: visibility (such as public and private)
     TypeId return_type_id;
     Vec<CheckedParameter> parameters;
@@ -99,7 +148,7 @@ enum CheckedUnaryOperator {
 };
 
 struct CheckedExpression {
-    enum class Tag {
+    enum class Tag : u8 {
         Null,
         Int,
         String,
@@ -111,24 +160,27 @@ struct CheckedExpression {
 
     Tag tag{};
 
-    struct { TypeId type_id; } null;
-    struct { Spanned<int> value; } integer;
-    struct { Spanned<Str> value; } string;
-    struct { Spanned<CheckedVariable> var; } var;
-    struct { CheckedExpression *condition, *then, *else_; } if_;
-    struct {
-        CheckedExpression *left;
-        ExpressionDetails::Binary::Operation op;
-        CheckedExpression *right;
-        Span span;
-        TypeId type_id;
-    } binary_op;
-    struct UnaryOp {
-        CheckedExpression *left{};
-        CheckedUnaryOperator op{};
-        Span span{};
-        TypeId type_id;
-    } unary_op;
+    union {
+        struct { TypeId type_id; } null;
+        struct { Spanned<int> value; } integer;
+        // Points into the checked arena it was allocated with.
+        struct { Spanned<StrView> value; } string;
+        struct { Spanned<CheckedVariable> var; } var;
+        struct { CheckedExpression *condition, *then, *else_; } if_;
+        struct {
+            CheckedExpression *left;
+            ExpressionDetails::Binary::Operation op;
+            CheckedExpression *right;
+            Span span;
+            TypeId type_id;
+        } binary_op;
+        struct {
+            CheckedExpression *left;
+            CheckedUnaryOperator op;
+            Span span;
+            TypeId type_id;
+        } unary_op;
+    };
 
     static CheckedExpression Null(TypeId type_id) {
         return CheckedExpression{.tag = Tag::Null, .null = {type_id}};
@@ -138,7 +190,7 @@ struct CheckedExpression {
         return CheckedExpression{.tag=Tag::Int, .integer={value}};
     }
 
-    static CheckedExpression String(Spanned<Str> value) {
+    static CheckedExpression String(Spanned<StrView> value) {
         return CheckedExpression{.tag=Tag::String, .string={value}};
     }
 
@@ -183,7 +235,7 @@ struct CheckedExpression {
 };
 
 struct CheckedStatement {
-    enum class Tag {
+    enum class Tag : u8 {
         Expression,
         VarDecl,
         Return,
@@ -191,9 +243,11 @@ struct CheckedStatement {
 
     Tag tag{};
 
-    struct { CheckedExpression *expr; } expression;
-    struct { CheckedVarDecl decl; CheckedExpression *expr{}; } var_decl;
-    struct { CheckedExpression *expr{}; } return_;
+    union {
+        struct { CheckedExpression *expr; } expression;
+        struct { CheckedVarDecl decl; CheckedExpression *expr; } var_decl;
+        struct { CheckedExpression *expr; } return_;
+    };
 
     static CheckedStatement Expression(CheckedExpression *expr) {
         return CheckedStatement{.tag=Tag::Expression, .expression={expr}};
@@ -208,40 +262,102 @@ struct CheckedStatement {
     }
 };
 
+static constexpr u32 NO_SCOPE = UINT32_MAX;
+
+// Scopes live by value in `Project::scopes`, so they're kept small: most of
+// them are block scopes with a name or two, and there are lots of them.
 struct Scope {
 public:
     explicit Scope(Opt<ScopeId> parent = std::nullopt)
-            : parent(parent) {}
+            : parent_id(parent.has_value() ? static_cast<u32>(parent.value()) : NO_SCOPE) {}
 
     static bool can_access(ScopeId, ScopeId, const Project &);
 
+    [[nodiscard]] Opt<ScopeId> parent() const {
+        if (parent_id == NO_SCOPE) return std::nullopt;
+        return parent_id;
+    }
+
 public:
-    Opt<Str> namespace_name = std::nullopt;
-    Vec<CheckedVariable> variables{};
-    Vec<Id<RecordId>> records{};
-    Vec<Id<FunctionId>> functions{};
-    Vec<Id<TypeId>> types{};
-    Opt<ScopeId> parent = std::nullopt;
-    Vec<ScopeId> children{};
+    SymbolTable symbols{};
+    // `Symbols::Empty` unless this is the scope of a namespace.
+    Symbol namespace_name{Symbols::Empty};
+    u32 parent_id{NO_SCOPE};
+    // Children form a list through `next_sibling`, newest first.
+    u32 first_child{NO_SCOPE};
+    u32 next_sibling{NO_SCOPE};
 };
 
 class Project {
 public:
-    Project() {
-        auto *project_global_scope = new Scope();
-        this->scopes.push_back(project_global_scope);
-    }
+    // `jobs` is the number of threads `parallel_for` spreads work over.
+    explicit Project(const Ast &ast, usz jobs = 1);
+    ~Project();
 
+    // Types are hash-consed: structurally equal types always get the same id,
+    // so types can be compared by id. Safe to call from several threads.
     TypeId find_or_add_type_id(const CheckedType&);
+    // Safe to call from several threads; see `parallel_for`.
     ScopeId create_scope(ScopeId);
+    void add_child_scope(ScopeId parent, ScopeId child);
     ErrorOr<Void> add_var_to_scope(ScopeId, const CheckedVariable&, Span);
-    Opt<CheckedVariable> find_var_in_scope(ScopeId, const Str&);
-    ErrorOr<Void> add_type_to_scope(ScopeId, Str, TypeId, Span);
-    Opt<TypeId> find_type_in_scope(ScopeId, const Str&);
-    ErrorOr<Void> add_function_to_scope(ScopeId, Str, FunctionId, Span);
-    Opt<FunctionId> find_function_in_scope(ScopeId, const Str&);
-    ErrorOr<Void> add_record_to_scope(ScopeId, Str, RecordId, Span);
-    Opt<RecordId> find_record_in_scope(ScopeId, const Str&);
+    Opt<CheckedVariable> find_var_in_scope(ScopeId, Symbol);
+    ErrorOr<Void> add_type_to_scope(ScopeId, Symbol, TypeId, Span);
+    Opt<TypeId> find_type_in_scope(ScopeId, Symbol);
+    ErrorOr<Void> add_function_to_scope(ScopeId, Symbol, FunctionId, Span);
+    Opt<FunctionId> find_function_in_scope(ScopeId, Symbol);
+    ErrorOr<Void> add_record_to_scope(ScopeId, Symbol, RecordId, Span);
+    Opt<RecordId> find_record_in_scope(ScopeId, Symbol);
+
+    // Runs `task(i)` for every `i` below `count` on the thread pool. The tasks
+    // may create scopes, add names to scopes that no other task looks into,
+    // and intern types; everything else they must only read.
+    void parallel_for(usz count, const Fn<void(usz)> &task);
+
+    [[nodiscard]] Opt<FunctionId> current_function() const { return worker().current_function; }
+    void set_current_function(Opt<FunctionId> id) { worker().current_function = id; }
+    // The inference variables of the function being checked on this thread.
+    TypeInference &inference() { return *worker().inference; }
+    // Where this thread allocates checked statements and expressions.
+    Arena &checked_arena() { return worker().checked; }
+
+    // The AST expressions and type names are looked up in: the program's,
+    // or while this thread checks a deferred body, the one it was parsed into.
+    const Ast &ast() const {
+        const Worker &worker = this->worker();
+        return worker.checking_body ? *worker.body_ast : m_ast;
+    }
+    // Parses a body the parser deferred, into an AST of this thread's own so
+    // threads can parse the bodies they check at the same time. Skipping the
+    // body interned its names, so parsing it only reads the interner. On a
+    // lexical or syntax error, keeps it for `first_syntax_error` and returns
+    // nothing.
+    Opt<Block<ParsedStatement *>> parse_deferred_body(const DeferredBody&);
+    // Between these, `ast()` is the one `parse_deferred_body` parsed into.
+    void begin_deferred_body() { worker().checking_body = true; }
+    void end_deferred_body() { worker().checking_body = false; }
+    // The syntax error earliest in the source from every deferred body parsed.
+    [[nodiscard]] Opt<Error> first_syntax_error() const;
+
+    // Memoizes `substitute_typevars_in_type`. Substitutions are interned so
+    // a result can be looked up by (type, substitution) without comparing maps.
+    // Adding a result for a type already in the cache replaces it.
+    SubstitutionId find_or_add_substitution(const Map<TypeId, TypeId>&);
+    Opt<TypeId> find_substituted_type(TypeId, SubstitutionId);
+    void add_substituted_type(TypeId, SubstitutionId, TypeId result);
+
+    struct CacheStats {
+        usz lookups, hits;
+    };
+    [[nodiscard]] CacheStats substitution_stats() const;
+
+    struct Stats {
+        usz types, scopes, functions, records;
+        // Bytes of checked IR in the arenas of all workers.
+        usz checked_bytes;
+        CacheStats substitutions;
+    };
+    [[nodiscard]] Stats stats() const;
 
     Str typename_for_type_id(TypeId type_id) {
         switch (this->types[type_id].tag) {
@@ -255,9 +371,9 @@ public:
                     case STRING_TYPE_ID: return "str";
                     default: return "<invalid>";
                 }
-            case CheckedType::Tag::TypeVariable: return this->types[type_id].type_variable.variable;
+            case CheckedType::Tag::TypeVariable: return Str(interner.text(this->types[type_id].type_variable.variable));
             case CheckedType::Tag::GenericInstance: {
-                Str output = this->records[this->types[type_id].generic_instance.record_id].name;
+                Str output{interner.text(this->records[this->types[type_id].generic_instance.record_id].name)};
                 output += "[";
                 bool first = true;
                 for (const auto &arg : this->types[type_id].generic_instance.generic_arguments) {
@@ -268,16 +384,99 @@ public:
                 output += "]";
                 return output;
             }
-            case CheckedType::Tag::Record: return this->records[this->types[type_id].record.record_id].name;
+            case CheckedType::Tag::Record: return Str(interner.text(this->records[this->types[type_id].record.record_id].name));
             case CheckedType::Tag::RawPtr: return std::format("raw {}", typename_for_type_id(this->types[type_id].rawptr.subtype));
+            case CheckedType::Tag::Inference: return "<?>";
         }
     }
 
 public:
     Vec<CheckedFunction> functions{};
     Vec<CheckedRecord> records{};
-    Vec<Scope *> scopes{};
-    Vec<CheckedType> types{};
+    ChunkedVec<Scope> scopes{};
+    ChunkedVec<CheckedType> types{};
+
+private:
+    void add_prelude_record(Symbol name, Symbol type_parameter);
+    Opt<usz> resolve(ScopeId, Symbol, SymbolKind);
+
+    // Caches where lookups from deep block scopes resolve to. Entries are
+    // stamped with a per-kind generation that moves on whenever a name of
+    // that kind is added to any scope, so stale entries never hit. Variables
+    // are bound far more often, so their entries are also stamped with the
+    // generation of the name itself, and only binding that name moves it.
+    struct ResolvedName {
+        ScopeId scope_id{SIZE_MAX};
+        Symbol name{};
+        SymbolKind kind{};
+        bool found{};
+        u32 generation{};
+        u32 name_generation{};
+        usz value{};
+    };
 
-    Opt<FunctionId> current_function_index = std::nullopt;
+    struct SubstitutedType {
+        usz key{SIZE_MAX};
+        TypeId result{};
+    };
+
+    // An interned substitution, its pairs at `begin` in `substitution_pairs`.
+    struct InternedSubstitution {
+        usz hash{0};
+        u32 begin{0}, size{0};
+        // 0 for an empty slot; the empty substitution is never interned.
+        SubstitutionId id{0};
+    };
+
+    // What each thread of the pool is doing. The lookup cache is per thread:
+    // while tasks run in parallel, a thread only ever adds names to scopes
+    // that only it looks into, so it never has to see another's additions.
+    struct Worker {
+        Vec<ResolvedName> resolved{Vec<ResolvedName>(4096)};
+        u32 generations[4]{};
+        // By `Symbol`; names past the end have never been bound.
+        Vec<u32> variable_generations{};
+        Opt<FunctionId> current_function{};
+        Unique<TypeInference> inference;
+        Arena checked{};
+
+        // Made on the first deferred body; the parser is remade for each file.
+        Unique<Ast> body_ast{};
+        Unique<Tokenizer> body_tokenizer{};
+        Unique<Parser> body_parser{};
+        bool checking_body{false};
+        Vec<Error> syntax_errors{};
+
+        // Each thread interns substitutions on its own, so ids from one
+        // thread mean nothing to another.
+        // Open addressing on the hash of the pairs, kept at most half full,
+        // so looking up a known substitution allocates nothing.
+        Vec<InternedSubstitution> substitution_ids{Vec<InternedSubstitution>(64)};
+        Vec<std::pair<TypeId, TypeId>> substitution_pairs{};
+        usz substitution_count{0};
+        // Open addressing on (type, substitution), kept at most half full.
+        Vec<SubstitutedType> substituted{Vec<SubstitutedType>(256)};
+        usz substituted_count{0};
+        CacheStats substitution_stats{0, 0};
+    };
+    Worker &worker() { return *m_workers[ThreadPool::current_worker()]; }
+    const Worker &worker() const { return *m_workers[ThreadPool::current_worker()]; }
+    void invalidate_resolved();
+
+    // The program being checked.
+    const Ast &m_ast;
+    Vec<Unique<Worker>> m_workers;
+    ThreadPool m_pool;
+
+    // Open addressing over `types`, split into shards with a lock each so
+    // threads interning different types rarely wait on each other. Builtins
+    // have fixed ids and aren't in it.
+    static constexpr usz TYPE_SHARDS = 16;
+    struct alignas(64) TypeShard {
+        std::mutex mutex{};
+        Vec<TypeId> table{};
+        usz count{0};
+    };
+    void grow_type_shard(TypeShard &);
+    TypeShard m_type_shards[TYPE_SHARDS]{};
 };
\ No newline at end of file
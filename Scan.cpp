@@ -0,0 +1,208 @@
+#include "Scan.hpp"
+
+#if defined(__x86_64__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static inline bool is_identifier_byte(char c) {
+    return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_';
+}
+
+static const char *identifier_scalar(const char *p, const char *end) {
+    while (p < end and is_identifier_byte(*p)) p++;
+    return p;
+}
+
+static const char *digits_scalar(const char *p, const char *end) {
+    while (p < end and ((*p >= '0' and *p <= '9') or *p == '_')) p++;
+    return p;
+}
+
+static const char *line_scalar(const char *p, const char *end) {
+    while (p < end and *p != '\n') p++;
+    return p;
+}
+
+static const char *string_scalar(const char *p, const char *end) {
+    while (p < end and *p != '"' and *p != '\\' and *p != '{' and *p != '}' and *p != '\n') p++;
+    return p;
+}
+
+static const char *spaces_scalar(const char *p, const char *end) {
+    while (p < end and *p == ' ') p++;
+    return p;
+}
+
+static constexpr ScanKernels scalar_kernels{
+    "scalar", identifier_scalar, digits_scalar, line_scalar, string_scalar, spaces_scalar,
+};
+
+#ifdef SCAN_X86
+
+// Runs `stop` over whole blocks of `width` bytes. `stop` returns a bitmask
+// with one bit per byte that ends the run; the scalar kernel finishes the tail
+// so no load ever reads past `end`.
+#define SCAN_BLOCKS(width, stop)                                               \
+    while (end - p >= (width)) {                                               \
+        unsigned mask = stop(p);                                               \
+        if (mask != 0) return p + __builtin_ctz(mask);                         \
+        p += (width);                                                          \
+    }
+
+// Unsigned `lo <= c <= hi` for every byte.
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), offset);
+}
+
+static inline unsigned identifier_stop_sse2(const char *p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i letter = in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    __m128i digit = in_range_sse2(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return ~_mm_movemask_epi8(_mm_or_si128(letter, _mm_or_si128(digit, underscore))) & 0xFFFF;
+}
+
+static inline unsigned digits_stop_sse2(const char *p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i digit = in_range_sse2(v, '0', '9');
+    __m128i underscore = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return ~_mm_movemask_epi8(_mm_or_si128(digit, underscore)) & 0xFFFF;
+}
+
+static inline unsigned line_stop_sse2(const char *p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+}
+
+static inline unsigned string_stop_sse2(const char *p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i quote = _mm_cmpeq_epi8(v, _mm_set1_epi8('"'));
+    __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    __m128i brace = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('{')), _mm_cmpeq_epi8(v, _mm_set1_epi8('}')));
+    __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, backslash), _mm_or_si128(brace, newline)));
+}
+
+static inline unsigned spaces_stop_sse2(const char *p) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    return ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' '))) & 0xFFFF;
+}
+
+static const char *identifier_sse2(const char *p, const char *end) {
+    SCAN_BLOCKS(16, identifier_stop_sse2)
+    return identifier_scalar(p, end);
+}
+
+static const char *digits_sse2(const char *p, const char *end) {
+    SCAN_BLOCKS(16, digits_stop_sse2)
+    return digits_scalar(p, end);
+}
+
+static const char *line_sse2(const char *p, const char *end) {
+    SCAN_BLOCKS(16, line_stop_sse2)
+    return line_scalar(p, end);
+}
+
+static const char *string_sse2(const char *p, const char *end) {
+    SCAN_BLOCKS(16, string_stop_sse2)
+    return string_scalar(p, end);
+}
+
+static const char *spaces_sse2(const char *p, const char *end) {
+    SCAN_BLOCKS(16, spaces_stop_sse2)
+    return spaces_scalar(p, end);
+}
+
+static constexpr ScanKernels sse2_kernels{
+    "sse2", identifier_sse2, digits_sse2, line_sse2, string_sse2, spaces_sse2,
+};
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(hi - lo))), offset);
+}
+
+AVX2 static inline unsigned identifier_stop_avx2(const char *p) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i letter = in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    __m256i digit = in_range_avx2(v, '0', '9');
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(letter, _mm256_or_si256(digit, underscore))));
+}
+
+AVX2 static inline unsigned digits_stop_avx2(const char *p) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i digit = in_range_avx2(v, '0', '9');
+    __m256i underscore = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(digit, underscore)));
+}
+
+AVX2 static inline unsigned line_stop_avx2(const char *p) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+}
+
+AVX2 static inline unsigned string_stop_avx2(const char *p) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    __m256i quote = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"'));
+    __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+    __m256i brace = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('}')));
+    __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(quote, backslash), _mm256_or_si256(brace, newline)));
+}
+
+AVX2 static inline unsigned spaces_stop_avx2(const char *p) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))));
+}
+
+AVX2 static const char *identifier_avx2(const char *p, const char *end) {
+    SCAN_BLOCKS(32, identifier_stop_avx2)
+    return identifier_sse2(p, end);
+}
+
+AVX2 static const char *digits_avx2(const char *p, const char *end) {
+    SCAN_BLOCKS(32, digits_stop_avx2)
+    return digits_sse2(p, end);
+}
+
+AVX2 static const char *line_avx2(const char *p, const char *end) {
+    SCAN_BLOCKS(32, line_stop_avx2)
+    return line_sse2(p, end);
+}
+
+AVX2 static const char *string_avx2(const char *p, const char *end) {
+    SCAN_BLOCKS(32, string_stop_avx2)
+    return string_sse2(p, end);
+}
+
+AVX2 static const char *spaces_avx2(const char *p, const char *end) {
+    SCAN_BLOCKS(32, spaces_stop_avx2)
+    return spaces_sse2(p, end);
+}
+
+static constexpr ScanKernels avx2_kernels{
+    "avx2", identifier_avx2, digits_avx2, line_avx2, string_avx2, spaces_avx2,
+};
+
+#undef AVX2
+#undef SCAN_BLOCKS
+
+#endif
+
+Vec<ScanKernels> available_scan_kernels() {
+    Vec<ScanKernels> kernels{scalar_kernels};
+#ifdef SCAN_X86
+    // Runs from a static initializer, possibly before libgcc's own.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) kernels.push_back(sse2_kernels);
+    if (__builtin_cpu_supports("avx2")) kernels.push_back(avx2_kernels);
+#endif
+    return kernels;
+}
+
+ScanKernels scan = available_scan_kernels().back();
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Common.hpp"
+
+// Kernels the tokenizer uses to skip over runs of bytes. Each one returns a
+// pointer to the first byte in [p, end) that ends the run, or `end`.
+struct ScanKernels {
+    const char *name;
+    // [A-Za-z0-9_]*
+    const char *(*identifier)(const char *p, const char *end);
+    // [0-9_]*
+    const char *(*digits)(const char *p, const char *end);
+    // Everything up to the next `\n`.
+    const char *(*line)(const char *p, const char *end);
+    // Everything up to the next `"`, `\`, `{`, `}` or `\n`.
+    const char *(*string)(const char *p, const char *end);
+    // ' '*
+    const char *(*spaces)(const char *p, const char *end);
+};
+
+// The kernels for the widest instruction set this CPU supports, selected once
+// at startup.
+extern ScanKernels scan;
+
+// Every kernel set usable on this CPU, narrowest first. Used by benchmarks to
+// compare implementations by assigning to `scan`.
+Vec<ScanKernels> available_scan_kernels();
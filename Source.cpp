@@ -0,0 +1,112 @@
+#include "Source.hpp"
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static Error load_error(const char *path) {
+    return Error{std::format("could not open file `{}`: {}", path, std::strerror(errno)), Span{}};
+}
+
+static bool read_all(int fd, Str &buffer) {
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n == 0) return true;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        buffer.append(chunk, n);
+    }
+}
+
+SourceFile::~SourceFile() {
+    if (is_mapped()) ::munmap(const_cast<char *>(m_data), m_mapping_size);
+}
+
+const Vec<u32> &SourceFile::line_starts() const {
+    if (m_line_starts.empty()) {
+        m_line_starts.push_back(0);
+        for (usz i = 0; i < m_size; i++)
+            if (m_data[i] == '\n') m_line_starts.push_back(i + 1);
+    }
+    return m_line_starts;
+}
+
+SourceFile::Location SourceFile::location(u32 offset) const {
+    const Vec<u32> &starts = line_starts();
+    usz line = std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin();
+    return {line, offset - starts[line - 1] + 1};
+}
+
+StrView SourceFile::line(usz line) const {
+    const Vec<u32> &starts = line_starts();
+    usz start = starts[line - 1];
+    usz end = line < starts.size() ? starts[line] - 1 : m_size;
+    return contents().substr(start, end - start);
+}
+
+ErrorOr<FileId> SourceMap::load(const char *path) {
+    // Spans only have room for 16-bit file ids.
+    if (m_files.size() > UINT16_MAX)
+        return Error{std::format("could not open file `{}`: too many source files", path), Span{}};
+
+    if (std::strcmp(path, "-") == 0) {
+        Str buffer{};
+        if (not read_all(STDIN_FILENO, buffer)) return load_error(path);
+        m_files.push_back(std::make_unique<SourceFile>(path, std::move(buffer)));
+        return m_files.size() - 1;
+    }
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return load_error(path);
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0) {
+        ::close(fd);
+        return load_error(path);
+    }
+
+    // Pipes, character devices and empty files can't (or needn't) be mapped.
+    if (not S_ISREG(st.st_mode) or st.st_size == 0) {
+        Str buffer{};
+        bool ok = read_all(fd, buffer);
+        ::close(fd);
+        if (not ok) return load_error(path);
+        m_files.push_back(std::make_unique<SourceFile>(path, std::move(buffer)));
+        return m_files.size() - 1;
+    }
+
+    // Reserve one byte more than the file, rounded up to whole pages, as
+    // anonymous zero pages and map the file over the front of it. The bytes
+    // after the end of the file are then guaranteed to read as NUL, even when
+    // the file size is an exact multiple of the page size.
+    usz size = st.st_size;
+    // Tokens and spans address the file with 32-bit offsets.
+    if (size > UINT32_MAX) {
+        ::close(fd);
+        return Error{std::format("could not open file `{}`: file is larger than 4 GiB", path), Span{}};
+    }
+    usz page = ::sysconf(_SC_PAGESIZE);
+    usz mapping_size = (size + 1 + page - 1) / page * page;
+
+    void *reserved = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        ::close(fd);
+        return load_error(path);
+    }
+    void *mapped = ::mmap(reserved, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        ::munmap(reserved, mapping_size);
+        return load_error(path);
+    }
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+
+    m_files.push_back(std::make_unique<SourceFile>(path, static_cast<const char *>(mapped), size, mapping_size));
+    return m_files.size() - 1;
+}
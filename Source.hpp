@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Common.hpp"
+
+// A loaded source file. Regular files are memory-mapped read-only; pipes and
+// stdin (`-`) are read into an owned buffer instead. Either way the contents
+// are followed by a NUL sentinel, so the tokenizer may look one byte past the
+// end without a bounds check.
+class SourceFile {
+public:
+    SourceFile(Str filename, const char *data, usz size, usz mapping_size)
+            : m_filename(std::move(filename)), m_data(data), m_size(size), m_mapping_size(mapping_size) {}
+    SourceFile(Str filename, Str buffer)
+            : m_filename(std::move(filename)), m_buffer(std::move(buffer)),
+              m_data(m_buffer.data()), m_size(m_buffer.size()) {}
+    ~SourceFile();
+
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+
+    [[nodiscard]] const Str &filename() const { return m_filename; }
+    [[nodiscard]] StrView contents() const { return {m_data, m_size}; }
+    [[nodiscard]] bool is_mapped() const { return m_mapping_size != 0; }
+
+    struct Location {
+        usz line, column;
+    };
+
+    // Hands over the line starts the tokenizer recorded, so diagnostics don't
+    // have to scan the file again.
+    void set_line_starts(Vec<u32> line_starts) { m_line_starts = std::move(line_starts); }
+
+    // 1-based line and column of the byte at `offset`.
+    [[nodiscard]] Location location(u32 offset) const;
+    // The text of 1-based line `line`, without its newline. O(1).
+    [[nodiscard]] StrView line(usz line) const;
+
+private:
+    Str m_filename;
+    Str m_buffer{};
+    const char *m_data;
+    usz m_size;
+    usz m_mapping_size{0};
+    // Offset of the first byte of each line; scanned for on first use unless
+    // the tokenizer already provided it.
+    mutable Vec<u32> m_line_starts{};
+
+    const Vec<u32> &line_starts() const;
+};
+
+// Owns every source file of a compilation. Files stay loaded (and mapped) for
+// the lifetime of the map so diagnostics can point back into them.
+class SourceMap {
+public:
+    ErrorOr<FileId> load(const char *path);
+
+    [[nodiscard]] const SourceFile &file(FileId id) const { return *m_files[id]; }
+    [[nodiscard]] SourceFile &file(FileId id) { return *m_files[id]; }
+    [[nodiscard]] usz size() const { return m_files.size(); }
+
+private:
+    Vec<Unique<SourceFile>> m_files{};
+};
@@ -0,0 +1,114 @@
+#include "Stats.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+
+static std::atomic<usz> s_allocations{0};
+static std::atomic<usz> s_allocated_bytes{0};
+
+static void *counted_allocation(usz size, usz alignment) {
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    s_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void *memory = alignment <= alignof(std::max_align_t)
+            ? std::malloc(size)
+            : std::aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+    if (memory == nullptr) throw std::bad_alloc();
+    return memory;
+}
+
+// The array and nothrow forms forward to these by default.
+void *operator new(usz size) { return counted_allocation(size, alignof(std::max_align_t)); }
+void *operator new(usz size, std::align_val_t alignment) {
+    return counted_allocation(size, static_cast<usz>(alignment));
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, usz) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void *memory, usz, std::align_val_t) noexcept { std::free(memory); }
+
+AllocationCount allocation_count() {
+    return AllocationCount{
+            s_allocations.load(std::memory_order_relaxed),
+            s_allocated_bytes.load(std::memory_order_relaxed),
+    };
+}
+
+usz peak_rss_bytes() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss * 1024;
+}
+
+PhaseTimer::~PhaseTimer() {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    AllocationCount now = allocation_count();
+    m_stats.add_phase(Stats::Phase{
+            .name = m_name,
+            .seconds = seconds,
+            .allocations = now.allocations - m_allocations.allocations,
+            .allocated_bytes = now.bytes - m_allocations.bytes,
+            .peak_rss_bytes = peak_rss_bytes(),
+    });
+}
+
+// Formats into a fixed buffer; every line printed here is short.
+template <typename... Args> static void append(Str &out, const char *format, Args... args) {
+    char line[256];
+    int length = std::snprintf(line, sizeof(line), format, args...);
+    out.append(line, std::min<usz>(length, sizeof(line) - 1));
+}
+
+void Stats::print_phases(std::ostream &out) const {
+    Str table{};
+    append(table, "%-10s %10s %12s %12s %14s\n", "phase", "time (ms)", "allocations", "alloc (MB)", "peak RSS (MB)");
+    Phase total{"total", 0, 0, 0, 0};
+    for (const Phase &phase : m_phases) {
+        append(table, "%-10s %10.2f %12lu %12.1f %14.1f\n", phase.name, phase.seconds * 1e3, phase.allocations,
+               phase.allocated_bytes / 1e6, phase.peak_rss_bytes / 1e6);
+        total.seconds += phase.seconds;
+        total.allocations += phase.allocations;
+        total.allocated_bytes += phase.allocated_bytes;
+        total.peak_rss_bytes = std::max(total.peak_rss_bytes, phase.peak_rss_bytes);
+    }
+    append(table, "%-10s %10.2f %12lu %12.1f %14.1f\n", total.name, total.seconds * 1e3, total.allocations,
+           total.allocated_bytes / 1e6, total.peak_rss_bytes / 1e6);
+    out << table;
+}
+
+void Stats::print_counters(std::ostream &out) const {
+    Str table{};
+    for (const auto &[name, value] : m_counters) append(table, "%-24s %12lu\n", name, value);
+    for (const auto &[name, value] : m_rates) append(table, "%-24s %11.1f%%\n", name, value * 100);
+    out << table;
+}
+
+void Stats::print_json(std::ostream &out, bool phases, bool counters) const {
+    Str json = "{";
+    if (phases) {
+        json += "\"phases\": [";
+        for (usz i = 0; i < m_phases.size(); i++) {
+            const Phase &phase = m_phases[i];
+            append(json,
+                   "%s{\"name\": \"%s\", \"seconds\": %.6f, \"allocations\": %lu, \"allocated_bytes\": %lu, "
+                   "\"peak_rss_bytes\": %lu}",
+                   i == 0 ? "" : ", ", phase.name, phase.seconds, phase.allocations, phase.allocated_bytes,
+                   phase.peak_rss_bytes);
+        }
+        json += "]";
+    }
+    if (counters) {
+        json += phases ? ", \"counters\": {" : "\"counters\": {";
+        for (usz i = 0; i < m_counters.size(); i++)
+            append(json, "%s\"%s\": %lu", i == 0 ? "" : ", ", m_counters[i].first, m_counters[i].second);
+        for (usz i = 0; i < m_rates.size(); i++)
+            append(json, "%s\"%s\": %.4f", i == 0 and m_counters.empty() ? "" : ", ", m_rates[i].first,
+                   m_rates[i].second);
+        json += "}";
+    }
+    json += "}\n";
+    out << json;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Trace.hpp"
+#include <chrono>
+#include <ostream>
+
+// Heap allocations made by the whole process so far, counted by the
+// replacement `operator new` in Stats.cpp.
+struct AllocationCount {
+    usz allocations, bytes;
+};
+AllocationCount allocation_count();
+
+// Peak resident set size of the process so far.
+usz peak_rss_bytes();
+
+// Where a compilation spent its time and memory: one entry per phase, plus
+// named counts of what it produced (tokens, AST nodes, types, ...).
+class Stats {
+  public:
+    struct Phase {
+        const char *name;
+        double seconds;
+        usz allocations, allocated_bytes;
+        // Of the process, at the end of the phase.
+        usz peak_rss_bytes;
+    };
+
+    void add_phase(const Phase &phase) { m_phases.push_back(phase); }
+    void set(const char *counter, usz value) { m_counters.emplace_back(counter, value); }
+    // A fraction between 0 and 1, printed as a percentage after the counters.
+    void set_rate(const char *rate, double value) { m_rates.emplace_back(rate, value); }
+
+    [[nodiscard]] const Vec<Phase> &phases() const { return m_phases; }
+    [[nodiscard]] const Vec<std::pair<const char *, usz>> &counters() const { return m_counters; }
+    [[nodiscard]] const Vec<std::pair<const char *, double>> &rates() const { return m_rates; }
+
+    void print_phases(std::ostream &) const;
+    void print_counters(std::ostream &) const;
+    // One object with a "phases" array and/or a "counters" object, which also
+    // holds the rates.
+    void print_json(std::ostream &, bool phases, bool counters) const;
+
+  private:
+    Vec<Phase> m_phases{};
+    Vec<std::pair<const char *, usz>> m_counters{};
+    Vec<std::pair<const char *, double>> m_rates{};
+};
+
+// Records the time and allocations from its construction to its destruction
+// as a phase of `stats`, and as a span of the trace when tracing.
+class PhaseTimer {
+  public:
+    PhaseTimer(Stats &stats, const char *name)
+            : m_stats(stats), m_name(name), m_span(name), m_allocations(allocation_count()),
+              m_start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+  private:
+    Stats &m_stats;
+    const char *m_name;
+    TraceSpan m_span;
+    AllocationCount m_allocations;
+    std::chrono::steady_clock::time_point m_start;
+};
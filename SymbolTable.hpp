@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Common.hpp"
+#include <cstring>
+
+// A name can be defined in several of these at once in the same scope; a
+// record, for example, is also a type and has a constructor function.
+enum class SymbolKind : u8 { Variable, Type, Function, Record };
+
+// The names defined in one scope, keyed by interned name and kind. Most
+// scopes define at most a couple of names, so the first two live inline and
+// only bigger scopes get an open-addressing table on the heap.
+class SymbolTable {
+  public:
+    SymbolTable() = default;
+    ~SymbolTable() {
+        if (m_capacity != 0) delete[] m_slots;
+    }
+
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    SymbolTable(SymbolTable &&other) noexcept { take(other); }
+    SymbolTable &operator=(SymbolTable &&other) noexcept {
+        if (this != &other) {
+            if (m_capacity != 0) delete[] m_slots;
+            take(other);
+        }
+        return *this;
+    }
+
+    // Returns false, leaving the table unchanged, if the name is already there.
+    bool insert(Symbol name, SymbolKind kind, usz value) {
+        if (find(name, kind) != nullptr) return false;
+
+        Slot slot{key_for(name, kind), value};
+        if (m_capacity == 0 and m_size < INLINE_SLOTS) {
+            m_inline[m_size++] = slot;
+            return true;
+        }
+        if ((m_size + 1) * 2 > m_capacity) grow();
+        place(m_slots, m_capacity, slot);
+        m_size++;
+        return true;
+    }
+
+    [[nodiscard]] const usz *find(Symbol name, SymbolKind kind) const {
+        usz key = key_for(name, kind);
+        if (m_capacity == 0) {
+            for (u32 i = 0; i < m_size; i++)
+                if (m_inline[i].key == key) return &m_inline[i].value;
+            return nullptr;
+        }
+        usz mask = m_capacity - 1;
+        for (usz i = hash(key) & mask; m_slots[i].key != EMPTY; i = (i + 1) & mask) {
+            if (m_slots[i].key == key) return &m_slots[i].value;
+        }
+        return nullptr;
+    }
+
+    [[nodiscard]] bool contains(Symbol name, SymbolKind kind) const { return find(name, kind) != nullptr; }
+    [[nodiscard]] usz size() const { return m_size; }
+
+  private:
+    static constexpr usz EMPTY = SIZE_MAX;
+    static constexpr u32 INLINE_SLOTS = 2;
+
+    struct Slot {
+        usz key;
+        usz value;
+    };
+
+    static usz key_for(Symbol name, SymbolKind kind) { return static_cast<usz>(kind) << 32 | name; }
+    static usz hash(usz key) {
+        key *= 0x9E3779B97F4A7C15ull;
+        return key ^ (key >> 32);
+    }
+
+    static void place(Slot *slots, u32 capacity, Slot slot) {
+        usz mask = capacity - 1;
+        usz i = hash(slot.key) & mask;
+        while (slots[i].key != EMPTY) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+
+    void grow() {
+        u32 capacity = m_capacity == 0 ? 8 : m_capacity * 2;
+        auto *slots = new Slot[capacity];
+        for (u32 i = 0; i < capacity; i++) slots[i].key = EMPTY;
+        if (m_capacity == 0) {
+            for (u32 i = 0; i < m_size; i++) place(slots, capacity, m_inline[i]);
+        } else {
+            for (u32 i = 0; i < m_capacity; i++)
+                if (m_slots[i].key != EMPTY) place(slots, capacity, m_slots[i]);
+            delete[] m_slots;
+        }
+        m_slots = slots;
+        m_capacity = capacity;
+    }
+
+    void take(SymbolTable &other) {
+        std::memcpy(m_inline, other.m_inline, sizeof(m_inline));
+        m_capacity = other.m_capacity;
+        m_size = other.m_size;
+        other.m_capacity = other.m_size = 0;
+    }
+
+    // Only the first `m_size` inline slots are meaningful; once the table has
+    // spilled (`m_capacity != 0`) `m_slots` is in use instead.
+    union {
+        Slot m_inline[INLINE_SLOTS];
+        Slot *m_slots;
+    };
+    u32 m_capacity{0}, m_size{0};
+};
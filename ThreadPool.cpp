@@ -0,0 +1,100 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(usz workers) {
+    for (usz i = 0; i < std::max<usz>(workers, 1); i++) m_queues.push_back(std::make_unique<Queue>());
+    for (usz i = 1; i < m_queues.size(); i++) m_threads.emplace_back([this, i] { work_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &thread : m_threads) thread.join();
+}
+
+void ThreadPool::parallel_for(usz count, const Fn<void(usz)> &task) {
+    if (m_threads.empty() or count <= 1) {
+        for (usz i = 0; i < count; i++) task(i);
+        return;
+    }
+
+    usz workers = m_queues.size();
+    for (usz i = 0; i < workers; i++) {
+        std::lock_guard lock(m_queues[i]->mutex);
+        m_queues[i]->begin = count * i / workers;
+        m_queues[i]->end = count * (i + 1) / workers;
+    }
+
+    {
+        std::lock_guard lock(m_mutex);
+        m_task = &task;
+        m_busy = m_threads.size();
+        m_batch++;
+    }
+    m_wake.notify_all();
+
+    run_tasks(0);
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::work_loop(usz worker) {
+    s_current_worker = worker;
+    usz seen_batch = 0;
+    for (;;) {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop or m_batch != seen_batch; });
+            if (m_stop) return;
+            seen_batch = m_batch;
+        }
+
+        run_tasks(worker);
+
+        std::lock_guard lock(m_mutex);
+        if (--m_busy == 0) m_done.notify_one();
+    }
+}
+
+void ThreadPool::run_tasks(usz worker) {
+    Queue &queue = *m_queues[worker];
+    for (;;) {
+        usz index;
+        {
+            std::lock_guard lock(queue.mutex);
+            if (queue.begin == queue.end) index = SIZE_MAX;
+            else index = queue.begin++;
+        }
+        if (index != SIZE_MAX) (*m_task)(index);
+        // Tasks only ever move between queues, so once a steal comes back
+        // empty everything left is already claimed by a worker that will run it.
+        else if (not steal(worker)) return;
+    }
+}
+
+bool ThreadPool::steal(usz worker) {
+    usz workers = m_queues.size();
+    for (usz i = 1; i < workers; i++) {
+        Queue &victim = *m_queues[(worker + i) % workers];
+        usz begin, end;
+        {
+            std::lock_guard lock(victim.mutex);
+            usz left = victim.end - victim.begin;
+            if (left == 0) continue;
+            begin = victim.end - (left + 1) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+
+        Queue &queue = *m_queues[worker];
+        std::lock_guard lock(queue.mutex);
+        queue.begin = begin;
+        queue.end = end;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Common.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Runs data-parallel loops on a fixed set of threads. Each worker starts with
+// its own range of indices and, once that runs out, steals half of what is
+// left of another worker's, so a few expensive tasks don't leave the other
+// threads idle. The thread calling `parallel_for` takes part as worker 0.
+class ThreadPool {
+  public:
+    explicit ThreadPool(usz workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Calls `task(i)` once for every `i` below `count` and returns when all of
+    // the calls have. The order and the thread of the calls are unspecified.
+    void parallel_for(usz count, const Fn<void(usz)> &task);
+
+    [[nodiscard]] usz size() const { return m_queues.size(); }
+
+    // The index of the worker running on this thread; 0 outside of the pool.
+    static usz current_worker() { return s_current_worker; }
+
+  private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        usz begin{0}, end{0};
+    };
+
+    void work_loop(usz worker);
+    void run_tasks(usz worker);
+    bool steal(usz worker);
+
+    static inline thread_local usz s_current_worker = 0;
+
+    Vec<Unique<Queue>> m_queues{};
+    Vec<std::thread> m_threads{};
+
+    std::mutex m_mutex{};
+    std::condition_variable m_wake{}, m_done{};
+    const Fn<void(usz)> *m_task{nullptr};
+    usz m_batch{0}, m_busy{0};
+    bool m_stop{false};
+};
@@ -2,11 +2,9 @@
 
 #include "Common.hpp"
 
-#define TOKENS                                                                 \
-    X(Id, "identifier")                                                        \
-    X(Int, "integer")                                                          \
-    X(Float, "float")                                                          \
-    X(String, "string")                                                        \
+// Every reserved word. This list is the single source of truth for both the
+// token enum (via TOKENS) and the tokenizer's keyword table.
+#define KEYWORDS                                                               \
     X(Null, "null")                                                            \
                                                                                \
     X(If, "if")                                                                \
@@ -30,7 +28,14 @@
     X(IntType, "int")                                                          \
                                                                                \
     X(Weak, "weak")                                                            \
-    X(Raw, "raw")                                                              \
+    X(Raw, "raw")
+
+#define TOKENS                                                                 \
+    X(Id, "identifier")                                                        \
+    X(Int, "integer")                                                          \
+    X(Float, "float")                                                          \
+    X(String, "string")                                                        \
+    KEYWORDS                                                                   \
                                                                                \
     X(Minus, "-")                                                              \
     X(Asterisk, "*")                                                           \
@@ -63,27 +68,37 @@ struct Token {
 #undef X
     };
 
-    static const char *type_to_string(Type type) {
-        const char *strings[] = {
+    static constexpr const char *type_names[] = {
 #define X(id, repr) #id,
-            TOKENS
+        TOKENS
 #undef X
-        };
-        return strings[static_cast<usz>(type)];
-    }
+    };
 
-    static const char *repr(Type type) {
-        const char *strings[] = {
+    static constexpr const char *type_reprs[] = {
 #define X(id, repr) repr,
-            TOKENS
+        TOKENS
 #undef X
-        };
-        return strings[static_cast<usz>(type)];
-    }
+    };
+
+    static constexpr const char *type_to_string(Type type) { return type_names[static_cast<usz>(type)]; }
+    static constexpr const char *repr(Type type) { return type_reprs[static_cast<usz>(type)]; }
 
     Type type{};
-    Opt<Str> value;
-    Span span{};
+    FileId file_id{};
+    u32 offset{};
+    u32 length{};
+    // Only set for `Id` tokens.
+    Symbol symbol{};
+
+    [[nodiscard]] Span span() const { return Span{file_id, offset, length}; }
+
+    // The token's text as a slice of the source: the lexeme for identifiers,
+    // keywords and numbers, and the still-escaped body (without the quotes)
+    // for string literals.
+    [[nodiscard]] StrView text(StrView source) const {
+        if (type == Type::String) return source.substr(offset + 1, length - 2);
+        return source.substr(offset, length);
+    }
 
     [[nodiscard]] inline u8 precedence() const {
         switch (type) {
@@ -1,389 +1,455 @@
 #include "Tokenizer.hpp"
-#include <sstream>
-
-static Token::Type ident_type(Str s) {
-    switch (s[0]) {
-        case 'c':
-            if (s == "case") return Token::Type::Case;
-            break;
-        case 'd':
-            if (s == "default") return Token::Type::Default;
-            break;
-        case 'e':
-            if (s == "else") return Token::Type::Else;
-            if (s == "elif") return Token::Type::Elif;
-            break;
-        case 'f':
-            if (s == "false") return Token::Type::False;
-            if (s == "fun") return Token::Type::Fun;
-            break;
-        case 'g':
-            if (s == "guard") return Token::Type::Guard;
-            break;
-        case 'i':
-            if (s == "if") return Token::Type::If;
-            if (s == "int") return Token::Type::IntType;
-            if (s == "interface") return Token::Type::Interface;
-            break;
-        case 'n':
-            if (s == "null") return Token::Type::Null;
-            break;
-        case 'o':
-            if (s == "object") return Token::Type::Object;
-            break;
-        case 'r':
-            if (s == "raw") return Token::Type::Raw;
-            if (s == "return") return Token::Type::Return;
-            break;
-        case 's':
-            if (s == "static") return Token::Type::Static;
-            if (s == "str") return Token::Type::StrType;
-            if (s == "switch") return Token::Type::Switch;
-            break;
-        case 't':
-            if (s == "true") return Token::Type::True;
-            if (s == "then") return Token::Type::Then;
-            break;
-        case 'u':
-            if (s == "unsafe") return Token::Type::Unsafe;
-            break;
-        case 'w':
-            if (s == "weak") return Token::Type::Weak;
-            break;
+#include "Interner.hpp"
+#include "Scan.hpp"
+#include <array>
+#include <format>
+
+namespace {
+
+struct Keyword {
+    StrView text;
+    Token::Type type{Token::Type::Id};
+};
+
+constexpr Keyword keywords[] = {
+#define X(id, repr) {repr, Token::Type::id},
+    KEYWORDS
+#undef X
+};
+
+// Keywords are looked up in a perfect hash table indexed by the identifier's
+// length and its first and last bytes. The multipliers are searched for at
+// compile time, so classifying an identifier costs one hash and at most one
+// comparison.
+constexpr usz keyword_table_size = 64;
+
+struct KeywordHash {
+    usz length_factor, first_factor;
+
+    [[nodiscard]] constexpr usz operator()(StrView s) const {
+        return (s.length() * length_factor + static_cast<u8>(s.front()) * first_factor
+                + static_cast<u8>(s.back())) & (keyword_table_size - 1);
     }
-    return Token::Type::Id;
+};
+
+constexpr KeywordHash find_keyword_hash() {
+    for (usz length_factor = 1; length_factor < 256; length_factor++) {
+        for (usz first_factor = 1; first_factor < 256; first_factor++) {
+            KeywordHash hash{length_factor, first_factor};
+            bool used[keyword_table_size]{};
+            bool collides = false;
+            for (const auto &keyword : keywords) {
+                usz slot = hash(keyword.text);
+                if (used[slot]) {
+                    collides = true;
+                    break;
+                }
+                used[slot] = true;
+            }
+            if (not collides) return hash;
+        }
+    }
+    return {0, 0};
+}
+
+constexpr KeywordHash keyword_hash = find_keyword_hash();
+static_assert(keyword_hash.length_factor != 0, "no perfect hash for KEYWORDS; grow keyword_table_size");
+
+constexpr std::array<Keyword, keyword_table_size> keyword_table = [] {
+    std::array<Keyword, keyword_table_size> table{};
+    for (const auto &keyword : keywords)
+        table[keyword_hash(keyword.text)] = keyword;
+    return table;
+}();
+
+} // namespace
+
+static inline bool is_digit(char c) { return c >= '0' and c <= '9'; }
+
+static inline bool is_identifier_start(char c) {
+    return (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or c == '_';
+}
+
+static Token::Type ident_type(StrView s) {
+    const Keyword &keyword = keyword_table[keyword_hash(s)];
+    return keyword.text == s ? keyword.type : Token::Type::Id;
+}
+
+// The byte at the current position, for diagnostics.
+Span Tokenizer::make_span() const { return Span{m_file_id, m_pos, 1}; }
+
+// Builds a token for the source text between `start` and `m_pos`.
+Token Tokenizer::make_token(Token::Type type, usz start) const {
+    return Token{type, m_file_id, static_cast<u32>(start), static_cast<u32>(m_pos - start)};
 }
 
-TokenizeResult tokenize(const char *filename, Str source) {
-    Vec<Token> tokens{};
-    Vec<Error> errors{};
+void Tokenizer::advance(usz offset) { m_pos += offset; }
 
-    usz pos = 0, line = 1, column = 1;
-    bool continues = false, string_interp = false;
-    Vec<usz> indent_stack{0};
+// Advances past the run of bytes matched by one of the `scan` kernels.
+void Tokenizer::skip(const char *(*kernel)(const char *, const char *)) {
+    const char *p = m_source.data() + m_pos;
+    advance(kernel(p, m_source.data() + m_source.length()) - p);
+}
 
-    auto make_span = [&](usz len = 1) -> Span {
-        return Span{filename, line, column - len, len};
-    };
+Token Tokenizer::next() {
+    m_count++;
+    Token token{};
+    if (m_peeked.has_value()) {
+        token = m_peeked.value();
+        m_peeked.reset();
+    } else {
+        token = lex();
+    }
+    if (token.type != Token::Type::Dedent) return token;
+
+    Token following = lex();
+    if (following.type == Token::Type::Indent) {
+        token.type = Token::Type::Newline;
+        return token;
+    }
+    m_peeked = following;
+    return token;
+}
 
-    auto advance = [&](usz offset = 1) {
-        pos += offset;
-        column += offset;
-    };
+Opt<Token> Tokenizer::skip_block() {
+    // Merged `Dedent`/`Indent` pairs come out as `Newline`s and leave the
+    // depth alone.
+    usz depth = 0;
+    for (;;) {
+        Token token = next();
+        if (token.type == Token::Type::Newline) continue;
+        // Up to the first `Indent`, anything else means there is no block.
+        if (depth == 0 and token.type != Token::Type::Indent) return token;
+        switch (token.type) {
+            case Token::Type::Indent: depth++; break;
+            case Token::Type::Dedent:
+                if (--depth == 0) return std::nullopt;
+                break;
+            case Token::Type::Eof: return std::nullopt;
+            default: break;
+        }
+    }
+}
+
+void Tokenizer::seek(usz offset, usz indent) {
+    m_pos = offset;
+    m_continues = false;
+    m_peeked.reset();
+    m_indent_stack.assign(1, 0);
+    if (indent > 0) m_indent_stack.push_back(indent);
+}
 
-    while (pos < source.length()) {
-        switch (source[pos]) {
+Token Tokenizer::lex() {
+    while (m_pos < m_source.length()) {
+        usz start = m_pos;
+        switch (m_source[m_pos]) {
             case '\0':
-                return {tokens, errors};
+                return make_token(Token::Type::Eof, m_pos);
 
             case '\r':
-            case ' ':
                 advance();
                 break;
 
-            case '\n': {
-                pos++;
+            case ' ':
+                skip(scan.spaces);
+                break;
 
-                usz indent = 0;
-                while (source[pos] == ' ') {
-                    indent++;
-                    advance();
-                }
-                if (continues) goto end;
-
-                if (indent > indent_stack.back()) {
-                    tokens.push_back(
-                        Token{Token::Type::Indent, {}, make_span(indent)});
-                    indent_stack.push_back(indent);
-                } else if (indent < indent_stack.back()) {
-                    tokens.push_back(
-                        Token{Token::Type::Dedent, {}, make_span(indent)});
-                    indent_stack.pop_back();
-                } else {
-                    tokens.push_back(
-                        Token{Token::Type::Newline, {}, make_span(indent)});
+            case '\n': {
+                // Layout tokens span the newline and the indentation after it.
+                advance();
+                m_line_starts.push_back(m_pos);
+                skip(scan.spaces);
+                usz indent = m_pos - start - 1;
+                if (m_continues) break;
+
+                Token token = make_token(Token::Type::Newline, start);
+
+                if (indent > m_indent_stack.back()) {
+                    token.type = Token::Type::Indent;
+                    m_indent_stack.push_back(indent);
+                } else if (indent < m_indent_stack.back()) {
+                    token.type = Token::Type::Dedent;
+                    m_indent_stack.pop_back();
                 }
-
-            end:
-                column = indent + 1;
-                line++;
-            } break;
+                return token;
+            }
 
             case '/':
-                if (pos + 1 < source.length() && source[pos + 1] == '/') {
-                    while (pos < source.length() && source[pos] != '\n') {
-                        advance();
-                    }
+                if (m_pos + 1 < m_source.length() && m_source[m_pos + 1] == '/') {
+                    skip(scan.line);
+                    advance();
+                    if (m_pos <= m_source.length()) m_line_starts.push_back(m_pos);
+                } else {
+                    m_errors.push_back(Error{"unexpected character `/`", make_span()});
                     advance();
-                    line++;
-                    column = 0;
                 }
                 break;
 
             case '-':
                 advance();
-                if (pos < source.length() && source[pos] == '>') {
+                if (m_pos < m_source.length() && m_source[m_pos] == '>') {
                     advance();
-                    tokens.push_back(Token{Token::Type::Arrow, {}, make_span(2)});
+                    return make_token(Token::Type::Arrow, start);
                 } else {
-                    tokens.push_back(Token{Token::Type::Minus, {}, make_span()});
+                    return make_token(Token::Type::Minus, start);
                 }
-                break;
 
             case '*':
                 advance();
-                tokens.push_back(Token{Token::Type::Asterisk, {}, make_span()});
-                break;
+                return make_token(Token::Type::Asterisk, start);
 
             case '=':
                 advance();
-                if (pos < source.length() && source[pos] == '=') {
+                if (m_pos < m_source.length() && m_source[m_pos] == '=') {
                     advance();
-                    tokens.push_back(
-                        Token{Token::Type::EqualsEquals, {}, make_span(2)});
+                    return make_token(Token::Type::EqualsEquals, start);
                 } else {
-                    tokens.push_back(Token{Token::Type::Equals, {}, make_span()});
+                    return make_token(Token::Type::Equals, start);
                 }
-                break;
 
             case '>':
                 advance();
-                tokens.push_back(Token{Token::Type::GreaterThan, {}, make_span()});
-                break;
+                return make_token(Token::Type::GreaterThan, start);
 
             case '<':
                 advance();
-                tokens.push_back(Token{Token::Type::LessThan, {}, make_span()});
-                break;
+                return make_token(Token::Type::LessThan, start);
 
             case '&':
                 advance();
-                tokens.push_back(Token{Token::Type::BitwiseAnd, {}, make_span()});
-                break;
+                return make_token(Token::Type::BitwiseAnd, start);
 
             case '(':
                 advance();
-                tokens.push_back(Token{Token::Type::OpenParen, {}, make_span()});
-                continues = true;
-                break;
+                m_continues = true;
+                return make_token(Token::Type::OpenParen, start);
 
             case ')':
                 advance();
-                tokens.push_back(Token{Token::Type::CloseParen, {}, make_span()});
-                continues = false;
-                break;
+                m_continues = false;
+                return make_token(Token::Type::CloseParen, start);
 
             case '[':
                 advance();
-                tokens.push_back(Token{Token::Type::OpenBracket, {}, make_span()});
-                continues = true;
-                break;
+                m_continues = true;
+                return make_token(Token::Type::OpenBracket, start);
 
             case ']':
                 advance();
-                tokens.push_back(Token{Token::Type::CloseBracket, {}, make_span()});
-                continues = false;
-                break;
+                m_continues = false;
+                return make_token(Token::Type::CloseBracket, start);
 
             case ',':
                 advance();
-                tokens.push_back(Token{Token::Type::Comma, {}, make_span()});
-                break;
+                return make_token(Token::Type::Comma, start);
 
             case ':':
                 advance();
-                tokens.push_back(Token{Token::Type::Colon, {}, make_span()});
-                break;
+                return make_token(Token::Type::Colon, start);
 
             case '.': {
-                if (pos + 1 < source.length() && std::isdigit(source[pos + 1])) {
-                    Str value{source[pos]};
+                if (m_pos + 1 < m_source.length() && is_digit(m_source[m_pos + 1])) {
                     advance();
-                    while (std::isdigit(source[pos])) {
-                        value.push_back(source[pos]);
-                        advance();
-                    }
-                    tokens.push_back(Token{Token::Type::Float, value,
-                                           make_span(value.length())});
-                } else if (pos + 1 < source.length() && source[pos + 1] == '.') {
+                    while (is_digit(m_source[m_pos])) advance();
+                    return make_token(Token::Type::Float, start);
+                } else if (m_pos + 1 < m_source.length() && m_source[m_pos + 1] == '.') {
                     advance(2);
-                    tokens.push_back(Token{Token::Type::Range, {}, make_span(2)});
+                    return make_token(Token::Type::Range, start);
                 } else {
                     advance();
-                    tokens.push_back(Token{Token::Type::Dot, {}, make_span()});
+                    return make_token(Token::Type::Dot, start);
                 }
-            } break;
+            }
 
             case '?':
                 advance();
-                tokens.push_back(Token{Token::Type::Question, {}, make_span()});
-                break;
+                return make_token(Token::Type::Question, start);
 
             case '"': {
+                // Escapes are only validated here; `unescape()` decodes the
+                // body when the parser actually needs the value.
                 advance();
-                Str value{};
-                while (pos < source.length() && source[pos] != '"') {
-                    switch (source[pos]) {
+                while (m_pos < m_source.length() && m_source[m_pos] != '"') {
+                    switch (m_source[m_pos]) {
                     case '\\': {
                         advance();
-                        switch (source[pos]) {
+                        switch (m_source[m_pos]) {
                         case '\\':
-                            value.append("\\");
-                            break;
-
                         case 't':
-                            value.append("\t");
-                            break;
-
                         case 'n':
-                            value.append("\n");
-                            break;
-
                         case 'r':
-                            value.append("\r");
                             break;
 
-                        default: {
-                            std::stringstream ss;
-                            ss << "invalid escape sequence `" << source[pos] << "`";
-                            errors.push_back(Error{ss.str(), make_span()});
-                        } break;
+                        default:
+                            m_errors.push_back(Error{std::format("invalid escape sequence `{}`", m_source[m_pos]), make_span()});
+                            break;
                         }
-                        advance();
+                        if (m_source[m_pos] != '\n') advance();
                     } break;
 
+                    case '\n':
+                        advance();
+                        m_line_starts.push_back(m_pos);
+                        break;
+
                     case '{': {
-                        if (pos + 1 < source.length() && source[pos + 1] == '{') {
-                            value.push_back('{');
+                        if (m_pos + 1 < m_source.length() && m_source[m_pos + 1] == '{') {
                             advance(2);
+                        } else {
+                            m_errors.push_back(
+                                Error{"open braces (`{`) must be escaped (`{{`)",
+                                      make_span()});
+                            advance();
                         }
-                        errors.push_back(
-                            Error{"open braces (`{`) must be escaped (`{{`)",
-                                  make_span()});
-                        advance();
                     } break;
 
                     case '}': {
-                        if (pos + 1 < source.length() && source[pos + 1] == '}') {
-                            value.push_back('}');
+                        if (m_pos + 1 < m_source.length() && m_source[m_pos + 1] == '}') {
                             advance(2);
+                        } else {
+                            m_errors.push_back(
+                                Error{"closing braces (`}`) must be escaped (`}}`)",
+                                      make_span()});
+                            advance();
                         }
-                        errors.push_back(
-                            Error{"closing braces (`}`) must be escaped (`}}`)",
-                                  make_span()});
-                        advance();
                     } break;
 
                     default:
-                        value.push_back(source[pos]);
-                        advance();
+                        skip(scan.string);
                         break;
                     }
                 }
                 advance();
-                tokens.push_back(
-                    Token{Token::Type::String, value, make_span(value.length())});
-            } break;
+                return make_token(Token::Type::String, start);
+            }
 
             default: {
-                if (std::isalpha(source[pos]) || source[pos] == '_') {
-                    Str value{};
-                    while (std::isalnum(source[pos]) || source[pos] == '_') {
-                        value.push_back(source[pos]);
-                        pos++;
-                        column++;
-                    }
-                    tokens.push_back(Token{ident_type(value),
-                                           std::make_optional(value),
-                                           make_span(value.length())});
-                    continue;
+                if (is_identifier_start(m_source[m_pos])) {
+                    skip(scan.identifier);
+                    StrView text = m_source.substr(start, m_pos - start);
+                    Token token = make_token(ident_type(text), start);
+                    if (token.type == Token::Type::Id) token.symbol = interner.intern(text);
+                    return token;
                 }
-                if (std::isdigit(source[pos])) {
-                    Str value;
+                if (is_digit(m_source[m_pos])) {
                     bool is_float = false;
 
-                    if (source[pos] == '0' && pos + 1 < source.length()) {
-                        if (source[pos + 1] == 'x') {
-                            pos += 2;
-                            column += 2;
-                            value = "0x";
-                            while (pos < source.length() &&
-                                   ((source[pos] >= '0' && source[pos] <= '9') ||
-                                    (source[pos] >= 'a' && source[pos] <= 'f') ||
-                                    (source[pos] >= 'A' && source[pos] <= 'F'))) {
-                                value.push_back(source[pos]);
-                                pos++;
-                                column++;
+                    if (m_source[m_pos] == '0' && m_pos + 1 < m_source.length()) {
+                        if (m_source[m_pos + 1] == 'x') {
+                            advance(2);
+                            while (m_pos < m_source.length() &&
+                                   ((m_source[m_pos] >= '0' && m_source[m_pos] <= '9') ||
+                                    (m_source[m_pos] >= 'a' && m_source[m_pos] <= 'f') ||
+                                    (m_source[m_pos] >= 'A' && m_source[m_pos] <= 'F'))) {
+                                advance();
                             }
                             goto done;
-                        } else if (source[pos + 1] == 'b') {
-                            pos += 2;
-                            column += 2;
-                            value = "0b";
-                            while (pos < source.length() &&
-                                   (source[pos] == '0' || source[pos] == '1')) {
-                                value.push_back(source[pos]);
-                                pos++;
-                                column++;
+                        } else if (m_source[m_pos + 1] == 'b') {
+                            advance(2);
+                            while (m_pos < m_source.length() &&
+                                   (m_source[m_pos] == '0' || m_source[m_pos] == '1')) {
+                                advance();
                             }
                             goto done;
                         }
                     }
 
-                    while (std::isdigit(source[pos]) or source[pos] == '_') {
-                        if (source[pos] != '_') value.push_back(source[pos]);
-                        pos++;
-                        column++;
-                    }
-
-                    if (source[pos] == '.') {
-                        if (source[pos + 1] == '.') goto done; // This is a range.
+                    skip(scan.digits);
 
-                        pos++;
-                        column++;
-                        value.push_back('.');
+                    if (m_source[m_pos] == '.') {
+                        if (m_source[m_pos + 1] == '.') goto done; // This is a range.
 
+                        advance();
                         is_float = true;
-                        while (std::isdigit(source[pos])) {
-                            value.push_back(source[pos]);
-                            pos++;
-                            column++;
-                        }
+                        while (is_digit(m_source[m_pos])) advance();
                     }
 
                 done:
-                    tokens.push_back(Token{
-                        is_float ? Token::Type::Float : Token::Type::Int,
-                        std::make_optional(value), make_span(value.length())});
-                    continue;
+                    return make_token(is_float ? Token::Type::Float : Token::Type::Int, start);
                 }
-                std::stringstream ss;
-                ss << "unexpected character `" << source[pos] << "`";
-                errors.push_back(Error{ss.str(), make_span()});
+                m_errors.push_back(Error{std::format("unexpected character `{}`", m_source[m_pos]), make_span()});
                 advance();
             } break;
         }
     }
 
-    tokens.push_back(Token{Token::Type::Eof, {}, make_span()});
+    return make_token(Token::Type::Eof, m_pos);
+}
 
-    return {tokens, errors};
+static_assert(std::size(Token::type_names) <= 256, "token kinds are buffered as bytes");
+
+Token TokenBuffer::operator[](usz index) {
+    usz i = slot(index);
+    return Token{static_cast<Token::Type>(m_types[i]), m_tokenizer.file_id(), m_offsets[i], m_lengths[i], m_symbols[i]};
 }
 
-Vec<Token> normalize(Vec<Token> tokens) {
-    Vec<Token> toks{};
-    for (usz i = 0; i < tokens.size(); i++) {
-        if (tokens[i].type == Token::Type::Dedent) {
-            if (i + 1 < tokens.size() &&
-                tokens[i + 1].type == Token::Type::Indent) {
-                toks.push_back(Token{Token::Type::Newline, {}, tokens[i].span});
-                i++;
-            } else {
-                toks.push_back(tokens[i]);
-            }
-        } else {
-            toks.push_back(tokens[i]);
+Token::Type TokenBuffer::type(usz index) { return static_cast<Token::Type>(m_types[slot(index)]); }
+
+Opt<Token> TokenBuffer::skip_block(usz index) {
+    if (index != m_end) PANIC("skip_block() with tokens buffered past the block");
+    return m_tokenizer.skip_block();
+}
+
+void TokenBuffer::seek(usz offset, usz indent) {
+    m_tokenizer.seek(offset, indent);
+    m_begin = m_end = 0;
+}
+
+usz TokenBuffer::slot(usz index) {
+    while (index >= m_end) {
+        if (m_end - m_begin == m_types.size()) grow();
+        Token token = m_tokenizer.next();
+        usz i = m_end & (m_types.size() - 1);
+        m_types[i] = static_cast<u8>(token.type);
+        m_offsets[i] = token.offset;
+        m_lengths[i] = token.length;
+        m_symbols[i] = token.symbol;
+        m_end++;
+    }
+    return index & (m_types.size() - 1);
+}
+
+// Only needed while a parser checkpoint pins more tokens than fit.
+void TokenBuffer::grow() {
+    usz size = m_types.size() * 2;
+    Vec<u8> types(size);
+    Vec<u32> offsets(size), lengths(size);
+    Vec<Symbol> symbols(size);
+    for (usz i = m_begin; i < m_end; i++) {
+        types[i & (size - 1)] = m_types[i & (m_types.size() - 1)];
+        offsets[i & (size - 1)] = m_offsets[i & (m_types.size() - 1)];
+        lengths[i & (size - 1)] = m_lengths[i & (m_types.size() - 1)];
+        symbols[i & (size - 1)] = m_symbols[i & (m_types.size() - 1)];
+    }
+    m_types = std::move(types);
+    m_offsets = std::move(offsets);
+    m_lengths = std::move(lengths);
+    m_symbols = std::move(symbols);
+}
+
+Str unescape(StrView body) {
+    Str value{};
+    value.reserve(body.length());
+    for (usz i = 0; i < body.length(); i++) {
+        switch (body[i]) {
+            case '\\':
+                switch (body[++i]) {
+                    case '\\': value.push_back('\\'); break;
+                    case 't': value.push_back('\t'); break;
+                    case 'n': value.push_back('\n'); break;
+                    case 'r': value.push_back('\r'); break;
+                    default: break; // Already reported by the tokenizer.
+                }
+                break;
+            case '{':
+            case '}':
+                value.push_back(body[i]);
+                if (i + 1 < body.length() && body[i + 1] == body[i]) i++;
+                break;
+            default:
+                value.push_back(body[i]);
+                break;
         }
     }
-    return toks;
-}
\ No newline at end of file
+    return value;
+}
@@ -2,11 +2,103 @@
 
 #include "Common.hpp"
 #include "Token.hpp"
+#include <algorithm>
 
-struct TokenizeResult {
-    Vec<Token> tokens;
-    Vec<Error> errors;
+// Produces the tokens of one source file on demand. A `Dedent` directly
+// followed by an `Indent` (one block ending where a sibling begins) is merged
+// into a single `Newline`, as the parser expects.
+class Tokenizer {
+  public:
+    // `source` must be followed by a NUL byte (as `std::string` and
+    // `SourceFile` contents are); the tokenizer relies on it to stop at the
+    // end of the input.
+    Tokenizer(FileId file_id, StrView source) : m_file_id(file_id), m_source(source) {}
+
+    // Returns `Eof` forever once the input is exhausted.
+    Token next();
+    // Goes over the indented block following the last token returned (a
+    // `:`), up to and including the `Dedent` that closes it, without
+    // handing out its tokens. Everything after is tokenized as if the
+    // block had been read token by token. Without a block, returns the
+    // token found instead of its `Indent`.
+    Opt<Token> skip_block();
+    // Continues at `offset`, as if inside a block indented by `indent`; used
+    // to come back to a block `skip_block()` went over.
+    void seek(usz offset, usz indent);
+
+    [[nodiscard]] FileId file_id() const { return m_file_id; }
+    [[nodiscard]] StrView source() const { return m_source; }
+    // Indentation of the innermost block the tokenizer is in.
+    [[nodiscard]] usz indent() const { return m_indent_stack.back(); }
+    [[nodiscard]] const Vec<Error> &errors() const { return m_errors; }
+    // Tokens returned by `next()` so far.
+    [[nodiscard]] usz count() const { return m_count; }
+    // Offset of the first byte of every line seen so far; covers the whole
+    // file once `next()` has returned `Eof`.
+    [[nodiscard]] Vec<u32> take_line_starts() { return std::move(m_line_starts); }
+
+  private:
+    Token lex();
+
+    [[nodiscard]] Span make_span() const;
+    [[nodiscard]] Token make_token(Token::Type, usz start) const;
+    void advance(usz offset = 1);
+    void skip(const char *(*kernel)(const char *, const char *));
+
+    FileId m_file_id;
+    StrView m_source;
+    Vec<Error> m_errors{};
+
+    usz m_pos{0};
+    usz m_count{0};
+    bool m_continues{false};
+    Vec<usz> m_indent_stack{0};
+    Vec<u32> m_line_starts{0};
+    Opt<Token> m_peeked{};
+};
+
+// The window of tokens the parser can currently see, indexed by absolute
+// token position. Tokens are pulled from the tokenizer as they are first
+// asked for and their slots reused once released, so memory stays bounded by
+// how far the parser looks back rather than by the size of the file. Kinds,
+// offsets, lengths and symbols are kept in separate arrays; a `Token` is only
+// assembled when the parser asks for one.
+class TokenBuffer {
+  public:
+    explicit TokenBuffer(Tokenizer &tokenizer)
+            : m_tokenizer(tokenizer), m_types(64), m_offsets(64), m_lengths(64), m_symbols(64) {}
+
+    // The token at `index`, which must not have been released.
+    Token operator[](usz index);
+    Token::Type type(usz index);
+
+    // `Tokenizer::skip_block()` right after token `index - 1`, the last one
+    // buffered.
+    Opt<Token> skip_block(usz index);
+    // `Tokenizer::seek()`, dropping every token buffered; indices start over
+    // from 0.
+    void seek(usz offset, usz indent);
+    [[nodiscard]] usz indent() const { return m_tokenizer.indent(); }
+
+    // Tokens before `index` will not be asked for again.
+    void release(usz index) { m_begin = std::max(m_begin, index); }
+
+  private:
+    // Makes sure `index` is buffered and returns its slot.
+    usz slot(usz index);
+    void grow();
+
+    Tokenizer &m_tokenizer;
+    // Always a power of two in size; token `i` lives at `i & (size - 1)`.
+    // `Token::Type` is int-sized: GCC builds tokens returned in registers
+    // through the stack, and mixing byte and wider stores there defeats
+    // store forwarding. The buffer still keeps kinds in a byte each.
+    Vec<u8> m_types;
+    Vec<u32> m_offsets;
+    Vec<u32> m_lengths;
+    Vec<Symbol> m_symbols;
+    usz m_begin{0}, m_end{0};
 };
 
-TokenizeResult tokenize(const char *filename, Str source);
-Vec<Token> normalize(Vec<Token> tokens);
\ No newline at end of file
+// Decodes the escape sequences in the body of a string literal token.
+Str unescape(StrView body);
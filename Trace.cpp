@@ -0,0 +1,81 @@
+#include "Trace.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <mutex>
+
+namespace detail {
+bool tracing_enabled = false;
+} // namespace detail
+
+namespace {
+
+struct Event {
+    const char *name;
+    Symbol detail;
+    std::chrono::steady_clock::time_point start, end;
+};
+
+struct ThreadEvents {
+    usz thread;
+    Vec<Event> events{};
+};
+
+std::chrono::steady_clock::time_point s_trace_start{};
+std::mutex s_threads_mutex{};
+// Owned here rather than by the threads, so events outlive the threads that
+// recorded them.
+Vec<Unique<ThreadEvents>> s_threads{};
+thread_local ThreadEvents *s_events = nullptr;
+
+ThreadEvents &thread_events() {
+    if (s_events == nullptr) {
+        std::lock_guard lock(s_threads_mutex);
+        s_threads.push_back(std::make_unique<ThreadEvents>(ThreadEvents{s_threads.size()}));
+        s_events = s_threads.back().get();
+    }
+    return *s_events;
+}
+
+} // namespace
+
+void start_tracing() {
+    s_trace_start = std::chrono::steady_clock::now();
+    detail::tracing_enabled = true;
+}
+
+void detail::record_span(const char *name, Symbol detail, std::chrono::steady_clock::time_point start) {
+    thread_events().events.push_back(Event{name, detail, start, std::chrono::steady_clock::now()});
+}
+
+static double microseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+Opt<Error> write_trace(const char *path) {
+    FILE *file = std::fopen(path, "w");
+    if (file == nullptr) return Error{std::format("could not write trace `{}`: {}", path, std::strerror(errno)), Span{}};
+
+    std::lock_guard lock(s_threads_mutex);
+    std::fputs("{\"traceEvents\": [\n", file);
+    bool first = true;
+    for (const auto &thread : s_threads) {
+        for (const Event &event : thread->events) {
+            std::fprintf(file, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %lu, \"ts\": %.3f, \"dur\": %.3f",
+                         first ? "" : ",\n", event.name, thread->thread, microseconds(event.start - s_trace_start),
+                         microseconds(event.end - event.start));
+            // Declaration names are identifiers, so they need no escaping.
+            if (event.detail != Symbols::Empty) {
+                StrView detail = interner.text(event.detail);
+                std::fprintf(file, ", \"args\": {\"name\": \"%.*s\"}", static_cast<int>(detail.size()), detail.data());
+            }
+            std::fputs("}", file);
+            first = false;
+        }
+    }
+    std::fputs("\n]}\n", file);
+    if (std::fclose(file) != 0)
+        return Error{std::format("could not write trace `{}`: {}", path, std::strerror(errno)), Span{}};
+    return std::nullopt;
+}
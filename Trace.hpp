@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Interner.hpp"
+#include <chrono>
+
+// Records spans of work as Chrome trace events (chrome://tracing, Perfetto).
+// Tracing is off unless `start_tracing()` was called; a disabled span costs
+// one branch. Each thread appends to a buffer of its own, so worker threads
+// never contend while tracing either.
+void start_tracing();
+// Writes every event recorded so far as a JSON trace to `path`.
+Opt<Error> write_trace(const char *path);
+
+namespace detail {
+// Only set before any worker thread starts.
+extern bool tracing_enabled;
+void record_span(const char *name, Symbol detail, std::chrono::steady_clock::time_point start);
+} // namespace detail
+
+[[nodiscard]] inline bool tracing() { return detail::tracing_enabled; }
+
+// A span from construction to destruction on the current thread. `name` must
+// outlive the trace; `detail` names what the span worked on, such as the
+// declaration being checked.
+class TraceSpan {
+  public:
+    explicit TraceSpan(const char *name, Symbol detail = Symbols::Empty) : m_name(name), m_detail(detail) {
+        if (tracing()) m_start = std::chrono::steady_clock::now();
+    }
+    ~TraceSpan() {
+        if (tracing()) detail::record_span(m_name, m_detail, m_start);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void set_detail(Symbol detail) { m_detail = detail; }
+
+  private:
+    const char *m_name;
+    Symbol m_detail;
+    std::chrono::steady_clock::time_point m_start{};
+};
@@ -0,0 +1,224 @@
+#include "TypeInference.hpp"
+#include <format>
+
+void TypeInference::rollback(Mark mark) {
+    while (m_trail.size() > mark.trail) {
+        m_variables[m_trail.back().index] = m_trail.back().old;
+        m_trail.pop_back();
+    }
+    m_variables.resize(mark.variables);
+}
+
+TypeId TypeInference::fresh(Project &project) {
+    u32 index = m_variables.size();
+    TypeId type_id = project.find_or_add_type_id(CheckedType::Inference(m_owner, index));
+    m_variables.push_back(Variable{index, 0, UNBOUND, type_id, UNBOUND});
+    return type_id;
+}
+
+TypeId TypeInference::instantiate(TypeId type_id, Project &project) {
+    Vec<std::pair<TypeId, TypeId>> instances{};
+    return instantiate(type_id, instances, project);
+}
+
+TypeId TypeInference::instantiate(TypeId type_id, Vec<std::pair<TypeId, TypeId>> &instances, Project &project) {
+    const CheckedType &type = project.types[type_id];
+    switch (type.tag) {
+        case CheckedType::Tag::TypeVariable: {
+            for (auto [type_variable, variable] : instances)
+                if (type_variable == type_id) return variable;
+            TypeId variable = fresh(project);
+            m_variables.back().origin = type_id;
+            instances.emplace_back(type_id, variable);
+            return variable;
+        }
+        case CheckedType::Tag::GenericInstance: {
+            Vec<TypeId> args = type.generic_instance.generic_arguments;
+            bool changed = false;
+            for (TypeId &arg : args) {
+                TypeId instance = instantiate(arg, instances, project);
+                changed |= instance != arg;
+                arg = instance;
+            }
+            if (not changed) return type_id;
+            return project.find_or_add_type_id(CheckedType::GenericInstance(type.generic_instance.record_id, args));
+        }
+        case CheckedType::Tag::RawPtr: {
+            TypeId subtype = instantiate(type.rawptr.subtype, instances, project);
+            if (subtype == type.rawptr.subtype) return type_id;
+            return project.find_or_add_type_id(CheckedType::RawPtr(subtype));
+        }
+        default: return type_id;
+    }
+}
+
+Opt<u32> TypeInference::variable_of(TypeId type_id, const Project &project) const {
+    const CheckedType &type = project.types[type_id];
+    if (type.tag != CheckedType::Tag::Inference or type.inference.owner != m_owner) return std::nullopt;
+    if (type.inference.variable >= m_variables.size()) return std::nullopt;
+    return type.inference.variable;
+}
+
+void TypeInference::set(u32 index, Variable variable) {
+    m_trail.push_back(TrailEntry{index, m_variables[index]});
+    m_variables[index] = variable;
+}
+
+u32 TypeInference::find(u32 index) {
+    u32 root = index;
+    while (m_variables[root].parent != root) root = m_variables[root].parent;
+
+    // Path compression; each step is undoable like any other write.
+    while (m_variables[index].parent != root) {
+        u32 next = m_variables[index].parent;
+        Variable variable = m_variables[index];
+        variable.parent = root;
+        set(index, variable);
+        index = next;
+    }
+    return root;
+}
+
+TypeId TypeInference::shallow_resolve(TypeId type_id, Project &project) {
+    for (;;) {
+        Opt<u32> variable = variable_of(type_id, project);
+        if (not variable.has_value()) return type_id;
+        const Variable &root = m_variables[find(variable.value())];
+        if (root.binding == UNBOUND) return root.type_id;
+        type_id = root.binding;
+    }
+}
+
+TypeId TypeInference::resolve(TypeId type_id, Project &project) { return resolve(type_id, UNBOUND, project); }
+
+TypeId TypeInference::resolve_or_unknown(TypeId type_id, Project &project) {
+    return resolve(type_id, UNKNOWN_TYPE_ID, project);
+}
+
+// Unbound variables resolve to `unbound`, or to themselves when it is `UNBOUND`.
+TypeId TypeInference::resolve(TypeId type_id, TypeId unbound, Project &project) {
+    type_id = shallow_resolve(type_id, project);
+    const CheckedType &type = project.types[type_id];
+    switch (type.tag) {
+        case CheckedType::Tag::Inference: {
+            Opt<u32> variable = variable_of(type_id, project);
+            if (variable.has_value()) {
+                const Variable &root = m_variables[find(variable.value())];
+                if (root.origin != UNBOUND) return root.origin;
+            }
+            return unbound == UNBOUND ? type_id : unbound;
+        }
+        case CheckedType::Tag::GenericInstance: {
+            Vec<TypeId> args = type.generic_instance.generic_arguments;
+            bool changed = false;
+            for (TypeId &arg : args) {
+                TypeId resolved = resolve(arg, unbound, project);
+                changed |= resolved != arg;
+                arg = resolved;
+            }
+            if (not changed) return type_id;
+            return project.find_or_add_type_id(CheckedType::GenericInstance(type.generic_instance.record_id, args));
+        }
+        case CheckedType::Tag::RawPtr: {
+            TypeId subtype = resolve(type.rawptr.subtype, unbound, project);
+            if (subtype == type.rawptr.subtype) return type_id;
+            return project.find_or_add_type_id(CheckedType::RawPtr(subtype));
+        }
+        default: return type_id;
+    }
+}
+
+bool TypeInference::occurs(u32 root, TypeId type_id, Project &project) {
+    type_id = shallow_resolve(type_id, project);
+    const CheckedType &type = project.types[type_id];
+    switch (type.tag) {
+        case CheckedType::Tag::Inference: {
+            Opt<u32> variable = variable_of(type_id, project);
+            return variable.has_value() and find(variable.value()) == root;
+        }
+        case CheckedType::Tag::GenericInstance:
+            for (TypeId arg : type.generic_instance.generic_arguments)
+                if (occurs(root, arg, project)) return true;
+            return false;
+        case CheckedType::Tag::RawPtr: return occurs(root, type.rawptr.subtype, project);
+        default: return false;
+    }
+}
+
+Opt<Error> TypeInference::unify(TypeId expected, TypeId actual, Span span, Project &project) {
+    Mark before = mark();
+    Opt<Error> error = unify_types(expected, actual, span, project);
+    if (error.has_value()) rollback(before);
+    return error;
+}
+
+Opt<Error> TypeInference::unify_types(TypeId expected_id, TypeId actual_id, Span span, Project &project) {
+    expected_id = shallow_resolve(expected_id, project);
+    actual_id = shallow_resolve(actual_id, project);
+    if (expected_id == actual_id) return std::nullopt;
+
+    Opt<u32> expected_variable = variable_of(expected_id, project);
+    Opt<u32> actual_variable = variable_of(actual_id, project);
+    if (expected_variable.has_value() and actual_variable.has_value()) {
+        u32 a = find(expected_variable.value()), b = find(actual_variable.value());
+        if (m_variables[a].rank < m_variables[b].rank) std::swap(a, b);
+
+        Variable child = m_variables[b], root = m_variables[a];
+        child.parent = a;
+        if (root.rank == child.rank) root.rank++;
+        if (root.origin == UNBOUND) root.origin = child.origin;
+        set(b, child);
+        set(a, root);
+        return std::nullopt;
+    }
+    if (expected_variable.has_value() or actual_variable.has_value()) {
+        u32 root = find(expected_variable.has_value() ? expected_variable.value() : actual_variable.value());
+        TypeId type_id = expected_variable.has_value() ? actual_id : expected_id;
+        if (occurs(root, type_id, project))
+            return Error{std::format("type {} would have to contain itself", project.typename_for_type_id(resolve(type_id, project))), span};
+
+        Variable variable = m_variables[root];
+        variable.binding = type_id;
+        set(root, variable);
+        return std::nullopt;
+    }
+
+    const CheckedType &expected = project.types[expected_id];
+    const CheckedType &actual = project.types[actual_id];
+    if (expected.tag == CheckedType::Tag::GenericInstance) {
+        RecordId record_id = expected.generic_instance.record_id;
+        const Vec<TypeId> &expected_args = expected.generic_instance.generic_arguments;
+
+        // An optional or weak pointer also accepts the value it wraps.
+        if (record_id == OPTIONAL_RECORD_ID or record_id == WEAK_PTR_RECORD_ID) {
+            Mark before = mark();
+            if (not unify_types(expected_args.front(), actual_id, span, project).has_value()) return std::nullopt;
+            rollback(before);
+        }
+
+        if (actual.tag == CheckedType::Tag::GenericInstance and actual.generic_instance.record_id == record_id) {
+            const Vec<TypeId> &actual_args = actual.generic_instance.generic_arguments;
+            if (actual_args.size() != expected_args.size())
+                return Error{
+                        std::format("mismatched number of generic parameters for {}", interner.text(project.records[record_id].name)),
+                        span
+                };
+
+            for (usz i = 0; i < expected_args.size(); i++) {
+                Opt<Error> error = unify_types(expected_args[i], actual_args[i], span, project);
+                if (error.has_value()) return error;
+            }
+            return std::nullopt;
+        }
+    }
+
+    if (expected.tag == CheckedType::Tag::RawPtr and actual.tag == CheckedType::Tag::RawPtr)
+        return unify_types(expected.rawptr.subtype, actual.rawptr.subtype, span, project);
+
+    return Error{
+            std::format("type mismatch; expected {}, but got {} instead",
+                        project.typename_for_type_id(resolve(expected_id, project)),
+                        project.typename_for_type_id(resolve(actual_id, project))),
+            span
+    };
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Project.hpp"
+
+// Solves equations between types with unknowns in them: the type variables
+// of a generic type that a value is checked against, and types nobody wrote
+// down, such as that of a bare `null`. Each unknown is a union-find node that
+// is either unbound or bound to a type. Every write goes on a trail, so a
+// failed or speculative unification is undone in time proportional to what
+// it touched rather than by copying any state.
+class TypeInference {
+  public:
+    explicit TypeInference(u32 owner) : m_owner(owner) {}
+
+    struct Mark {
+        usz trail, variables;
+    };
+    [[nodiscard]] Mark mark() const { return Mark{m_trail.size(), m_variables.size()}; }
+    // Forgets every variable and binding made since `mark`.
+    void rollback(Mark);
+    // Forgets every variable, once a function's types have all been resolved
+    // with `resolve_or_unknown`. Their ids are reused by the next function's
+    // variables.
+    void reset() { rollback(Mark{0, 0}); }
+
+    // A new unbound variable.
+    TypeId fresh(Project &);
+    // `type_id` with each of its type variables replaced by a new variable.
+    // The same type variable gets the same variable within one call.
+    TypeId instantiate(TypeId, Project &);
+
+    // Makes `expected` and `actual` the same type by binding variables in
+    // either; on a mismatch nothing is bound.
+    Opt<Error> unify(TypeId expected, TypeId actual, Span, Project &);
+
+    // `type_id` with bound variables replaced by their types, all the way
+    // down. Unbound variables made by `instantiate` turn back into the type
+    // variable they stand for.
+    TypeId resolve(TypeId, Project &);
+    // `resolve`, with any variable that is still unbound replaced by
+    // `UNKNOWN_TYPE_ID`, for types that outlive the function.
+    TypeId resolve_or_unknown(TypeId, Project &);
+
+  private:
+    static constexpr TypeId UNBOUND = SIZE_MAX;
+
+    struct Variable {
+        u32 parent;
+        u32 rank;
+        TypeId binding;
+        TypeId type_id;
+        // The type variable this one was instantiated from, or `UNBOUND`.
+        TypeId origin;
+    };
+    struct TrailEntry {
+        u32 index;
+        Variable old;
+    };
+
+    [[nodiscard]] Opt<u32> variable_of(TypeId, const Project &) const;
+    u32 find(u32);
+    void set(u32 index, Variable);
+    TypeId shallow_resolve(TypeId, Project &);
+    bool occurs(u32 variable, TypeId, Project &);
+    Opt<Error> unify_types(TypeId expected, TypeId actual, Span, Project &);
+    TypeId instantiate(TypeId, Vec<std::pair<TypeId, TypeId>> &instances, Project &);
+    TypeId resolve(TypeId, TypeId unbound, Project &);
+
+    u32 m_owner;
+    Vec<Variable> m_variables{};
+    Vec<TrailEntry> m_trail{};
+};
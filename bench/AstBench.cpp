@@ -0,0 +1,94 @@
+// Parses a file and walks every expression tree in it, reporting how much
+// memory the AST takes, how many heap allocations parsing makes, and how fast
+// a full traversal is.
+//
+//     ast_bench <file.lav> [iterations]
+
+#include "Ast.hpp"
+#include "Parser.hpp"
+#include "Source.hpp"
+#include "Tokenizer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// Every allocation in the process goes through here, so parsing can be
+// charged for its own.
+static usz s_allocations = 0;
+
+void *operator new(usz size) {
+    s_allocations++;
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, usz) noexcept { std::free(memory); }
+
+static void collect(const Block<ParsedStatement *> &body, Vec<ExprId> &out) {
+    for (ParsedStatement *stmt : body.elems) {
+        if (auto *ret = std::get_if<ParsedReturn *>(&stmt->var); ret and (*ret)->value.has_value())
+            out.push_back((*ret)->value.value());
+        else if (auto *var = std::get_if<ParsedVariable *>(&stmt->var))
+            out.push_back((*var)->expr);
+        else if (auto *expr = std::get_if<ParsedExpression *>(&stmt->var))
+            out.push_back((*expr)->expr);
+        else if (auto *fun = std::get_if<ParsedFunction *>(&stmt->var))
+            collect((*fun)->body, out);
+        else if (auto *object = std::get_if<ParsedObject *>(&stmt->var)) {
+            for (const ParsedField &field : (*object)->fields)
+                if (field.value.has_value()) out.push_back(field.value.value());
+            for (const ParsedMethod &method : (*object)->methods) collect(method.body, out);
+        }
+    }
+}
+
+static Vec<ExprId> roots(const Vec<ParsedStatement *> &stmts) {
+    Vec<ExprId> out{};
+    collect(Block<ParsedStatement *>{stmts}, out);
+    return out;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file.lav> [iterations]\n", argv[0]);
+        return 1;
+    }
+    usz iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+
+    SourceMap sources{};
+    ErrorOr<FileId> file_id = sources.load(argv[1]);
+    if (not file_id.has_value()) {
+        std::fprintf(stderr, "error: %s\n", file_id.error().message.c_str());
+        return 1;
+    }
+    StrView source = sources.file(file_id.value()).contents();
+
+    Tokenizer tokenizer(file_id.value(), source);
+    Ast ast{};
+    Parser parser(tokenizer, ast);
+    usz allocations_before = s_allocations;
+    auto start = std::chrono::steady_clock::now();
+    ErrorOr<Vec<ParsedStatement *>> stmts = parser.parse();
+    double parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    usz parse_allocations = s_allocations - allocations_before;
+    if (not stmts.has_value()) {
+        std::fprintf(stderr, "error: %s\n", stmts.error().message.c_str());
+        return 1;
+    }
+
+    Ast::Stats stats = ast.stats();
+    std::printf("input: %.1f MB, parsed in %.3f s with %lu allocations\n", source.size() / 1e6, parse_seconds,
+                parse_allocations);
+    std::printf("ast: %lu expressions, %lu types in %.1f MB; %.1f MB of declarations in the arena\n",
+                stats.expressions, stats.types, stats.bytes / 1e6, stats.arena.used / 1e6);
+
+    Vec<ExprId> trees = roots(stmts.value());
+    usz visited = 0;
+    start = std::chrono::steady_clock::now();
+    for (usz i = 0; i < iterations; i++)
+        for (ExprId root : trees) ast.walk(root, [&](ExprId) { visited++; });
+    double walk_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("walk: %lu nodes in %.2f ms\n", visited / iterations, walk_seconds * 1e3 / iterations);
+    return 0;
+}
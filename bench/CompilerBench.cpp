@@ -0,0 +1,113 @@
+// Measures the phases of the compiler separately on one input:
+//
+// - tokenize: the tokenizer alone, over the whole file;
+// - parse: the parser, which tokenizes on demand as in the compiler;
+// - check: setting up a `Project` and `typecheck_namespace`, on an AST
+//   parsed once up front.
+//
+// Each phase is repeated and reported as the median and 95th percentile
+// time, and as throughput in source bytes per second at the median.
+//
+//     compiler_bench [file.lav | --bytes N] [iterations] [-j jobs]
+//
+// Without a file, a generated program of 8 MB (or N bytes) is used.
+
+#include "Ast.hpp"
+#include "Checker.hpp"
+#include "Common.hpp"
+#include "Corpus.hpp"
+#include "Parser.hpp"
+#include "Project.hpp"
+#include "Source.hpp"
+#include "Tokenizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+struct Timings {
+    double median, p95;
+};
+
+template <typename Fn> static Timings measure(usz iterations, Fn fn) {
+    Vec<double> seconds{};
+    for (usz i = 0; i < iterations; i++) seconds.push_back(fn());
+    std::sort(seconds.begin(), seconds.end());
+    // Nearest rank.
+    usz p95 = std::min(seconds.size() - 1, (seconds.size() * 95 + 99) / 100 - 1);
+    return Timings{seconds[seconds.size() / 2], seconds[p95]};
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    const char *path = nullptr;
+    usz bytes = 8'000'000, iterations = 10, jobs = 1;
+    for (int i = 1; i < argc; i++) {
+        StrView arg = argv[i];
+        if (arg == "--bytes" and i + 1 < argc) bytes = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "-j" and i + 1 < argc) jobs = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg.ends_with(".lav")) path = argv[i];
+        else iterations = std::max<usz>(1, std::strtoul(argv[i], nullptr, 10));
+    }
+
+    SourceMap sources{};
+    Str generated{};
+    StrView source{};
+    if (path != nullptr) {
+        ErrorOr<FileId> file_id = sources.load(path);
+        if (not file_id.has_value()) {
+            std::fprintf(stderr, "error: %s\n", file_id.error().message.c_str());
+            return 1;
+        }
+        source = sources.file(file_id.value()).contents();
+    } else {
+        generated = generate_corpus(CorpusOptions{}, bytes);
+        source = generated;
+    }
+
+    Timings tokenize = measure(iterations, [&] {
+        auto start = std::chrono::steady_clock::now();
+        Tokenizer tokenizer(0, source);
+        while (tokenizer.next().type != Token::Type::Eof) {}
+        return seconds_since(start);
+    });
+
+    Timings parse = measure(iterations, [&] {
+        auto start = std::chrono::steady_clock::now();
+        Tokenizer tokenizer(0, source);
+        Ast ast{};
+        Parser parser(tokenizer, ast);
+        ErrorOr<Vec<ParsedStatement *>> stmts = parser.parse();
+        double seconds = seconds_since(start);
+        if (not stmts.has_value()) {
+            std::fprintf(stderr, "error: %s\n", stmts.error().message.c_str());
+            std::exit(1);
+        }
+        return seconds;
+    });
+
+    Tokenizer tokenizer(0, source);
+    Ast ast{};
+    Parser parser(tokenizer, ast);
+    (void) parser.parse();
+    usz errors = 0;
+    Timings check = measure(iterations, [&] {
+        auto start = std::chrono::steady_clock::now();
+        Project project(ast, jobs);
+        ScopeId scope_id = project.create_scope(0);
+        errors += typecheck_namespace(parser.parsed_namespace(), scope_id, project).has_value();
+        // Taken before the project is torn down.
+        return seconds_since(start);
+    });
+
+    std::printf("input: %.1f MB, %lu iterations, -j %lu\n", source.size() / 1e6, iterations, jobs);
+    std::printf("%-10s %10s %10s %10s\n", "phase", "median ms", "p95 ms", "MB/s");
+    for (auto [name, timings] : {std::pair{"tokenize", tokenize}, std::pair{"parse", parse}, std::pair{"check", check}})
+        std::printf("%-10s %10.2f %10.2f %10.1f\n", name, timings.median * 1e3, timings.p95 * 1e3,
+                    source.size() / timings.median / 1e6);
+    if (errors > 0) std::printf("note: the input has type errors; checking went on past them\n");
+    return 0;
+}
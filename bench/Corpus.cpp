@@ -0,0 +1,84 @@
+#include "Corpus.hpp"
+#include <format>
+
+static void indent(Str &out, usz level) { out.append(level * 4, ' '); }
+
+// `if a == b then count_0 else if b == 1 then a else ... else b`, with
+// `length` conditions.
+static Str if_chain(usz length, bool has_count) {
+    StrView values[] = {"a", "b", has_count ? "count_0" : "a"};
+    Str chain{};
+    for (usz i = 0; i < length; i++) {
+        switch (i % 3) {
+            case 0: chain += "if a == b then "; break;
+            case 1: chain += std::format("if b == {} then ", i); break;
+            case 2: chain += std::format("if a == {} then ", values[i % 3]); break;
+        }
+        chain += values[(i + 2) % 3];
+        chain += " else ";
+    }
+    chain += "b";
+    return chain;
+}
+
+static void append_group(Str &out, const CorpusOptions &options, usz group) {
+    out += std::format("interface Shape{}:\n", group);
+    out += "    fun area(int scale) > int\n";
+    out += "    fun describe() > str\n\n";
+
+    out += std::format("object SafePtr{}[A]:\n", group);
+    out += "    raw A ptr = null\n\n";
+    out += "    fun or_else(A fallback) > A:\n";
+    out += "        return if ptr == null then fallback else fallback\n\n";
+
+    for (usz depth = 0; depth < options.hierarchy_depth; depth++) {
+        if (depth == 0) out += std::format("object Node{}_0(Shape{}):\n", group, group);
+        else out += std::format("object Node{}_{} > Node{}_{}:\n", group, depth, group, depth - 1);
+
+        // Field 0 is always an int, so methods can refer to `count_0`.
+        for (usz field = 0; field < options.fields; field++) {
+            switch (field % 3) {
+                case 0: out += std::format("    int count_{} = {}\n", field, field); break;
+                case 1: out += std::format("    str label_{} = \"node {} {} {}\"\n", field, group, depth, field); break;
+                case 2: out += std::format("    SafePtr{}[int] ptr_{}\n", group, field); break;
+            }
+        }
+        if (options.fields > 0) out += "\n";
+
+        if (depth == 0) {
+            out += "    fun area(int scale) > int:\n";
+            out += "        return if scale == 0 then 0 else scale\n\n";
+        }
+        for (usz method = 0; method < options.methods; method++) {
+            if (method % 2 == 1 and options.fields > 2) {
+                out += std::format("    fun swap_{}(SafePtr{}[int] p) > SafePtr{}[int]:\n", method, group, group);
+                out += "        return if p == ptr_2 then p else ptr_2\n\n";
+            } else {
+                out += std::format("    fun pick_{}(int a int b) > int:\n", method);
+                out += std::format("        return {}\n\n", if_chain(options.if_chain, options.fields > 0));
+            }
+        }
+    }
+
+    for (usz level = 0; level < options.nesting; level++) {
+        indent(out, level);
+        out += std::format("fun helper{}_{}(int a) > int:\n", group, level);
+    }
+    for (usz level = options.nesting; level-- > 0;) {
+        indent(out, level + 1);
+        out += "return a\n";
+    }
+    out += "\n";
+}
+
+Str generate_corpus(const CorpusOptions &options) {
+    Str out{};
+    for (usz group = 0; group < options.groups; group++) append_group(out, options, group);
+    return out;
+}
+
+Str generate_corpus(const CorpusOptions &options, usz bytes) {
+    Str out{};
+    for (usz group = 0; out.size() < bytes; group++) append_group(out, options, group);
+    return out;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common.hpp"
+
+// Shapes a generated Lavender program. The program is built from groups,
+// each of them:
+//
+// - an interface and a generic `SafePtr`-like object with a raw pointer
+//   field;
+// - a chain of `hierarchy_depth` objects, each with the previous one as its
+//   `>` parent, with `fields` fields (some holding the generic object) and
+//   `methods` methods returning `if ... then ... else` chains of
+//   `if_chain` conditions;
+// - a top-level function with `nesting` functions declared one inside the
+//   other.
+//
+// The program compiles without diagnostics, and the checker checks every
+// object in it. Top-level functions are only parsed, as the checker does not
+// look at them yet.
+struct CorpusOptions {
+    usz groups = 100;
+    usz hierarchy_depth = 8;
+    usz fields = 4;
+    usz methods = 4;
+    usz if_chain = 6;
+    usz nesting = 6;
+};
+
+Str generate_corpus(const CorpusOptions &);
+// As many groups as it takes to reach about `bytes` of source.
+Str generate_corpus(const CorpusOptions &, usz bytes);
@@ -0,0 +1,34 @@
+// Writes a generated Lavender program to stdout; see Corpus.hpp for what it
+// contains.
+//
+//     lav_corpus [--bytes N | --groups N] [--depth N] [--fields N] [--methods N]
+//                [--if-chain N] [--nesting N]
+
+#include "Corpus.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+int main(int argc, char *argv[]) {
+    CorpusOptions options{};
+    usz bytes = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        StrView flag = argv[i];
+        usz value = std::strtoul(argv[i + 1], nullptr, 10);
+        if (flag == "--bytes") bytes = value;
+        else if (flag == "--groups") options.groups = value;
+        else if (flag == "--depth") options.hierarchy_depth = value;
+        else if (flag == "--fields") options.fields = value;
+        else if (flag == "--methods") options.methods = value;
+        else if (flag == "--if-chain") options.if_chain = value;
+        else if (flag == "--nesting") options.nesting = value;
+        else {
+            std::fprintf(stderr, "usage: %s [--bytes N | --groups N] [--depth N] [--fields N] [--methods N] "
+                                 "[--if-chain N] [--nesting N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Str source = bytes > 0 ? generate_corpus(options, bytes) : generate_corpus(options);
+    std::fwrite(source.data(), 1, source.size(), stdout);
+    return 0;
+}
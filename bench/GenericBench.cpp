@@ -0,0 +1,81 @@
+// Measures substituting type variables in nested generic instances, such as
+// `SafePtr[SafePtr[A]]` with `A` bound to `int`, for growing nesting depths.
+// Every round substitutes into a fresh set of types, as in code instantiating
+// many different records, and then into the same types again.
+//
+// Then measures inference: a chain of unknowns unified pairwise, as in a run
+// of `null` comparisons, one of them bound and all of them resolved.
+//
+//     generic_bench [substitutions]
+
+#include "Ast.hpp"
+#include "Checker.hpp"
+#include "Common.hpp"
+#include "Interner.hpp"
+#include "Project.hpp"
+#include "TypeInference.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+
+int main(int argc, char *argv[]) {
+    usz substitutions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20'000;
+
+    std::printf("%6s %12s %12s %10s\n", "depth", "fresh ns", "repeat ns", "hit rate");
+    for (usz depth : {1, 4, 8, 16}) {
+        Ast ast{};
+        Project project(ast);
+
+        // One record per type to substitute into, all generic in `A`.
+        TypeId type_variable = project.find_or_add_type_id(CheckedType::TypeVariable(interner.intern("A")));
+        Vec<TypeId> types{};
+        for (usz i = 0; i < substitutions; i++) {
+            RecordId record_id = project.records.size();
+            project.records.push_back(CheckedRecord{
+                    .name = interner.intern(std::format("SafePtr{}", i)),
+                    .generic_parameters = {type_variable},
+                    .fields = {},
+                    .scope_id = 0,
+            });
+
+            TypeId type_id = type_variable;
+            for (usz level = 0; level < depth; level++)
+                type_id = project.find_or_add_type_id(CheckedType::GenericInstance(record_id, {type_id}));
+            types.push_back(type_id);
+        }
+
+        Map<TypeId, TypeId> bindings{{type_variable, INT_TYPE_ID}};
+        double seconds[2]{};
+        for (double &round : seconds) {
+            auto start = std::chrono::steady_clock::now();
+            for (TypeId type_id : types) (void) substitute_typevars_in_type(type_id, &bindings, project);
+            round = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        Project::CacheStats stats = project.substitution_stats();
+        std::printf("%6lu %12.1f %12.1f %9.1f%%\n", depth, seconds[0] * 1e9 / substitutions,
+                    seconds[1] * 1e9 / substitutions, 100.0 * stats.hits / std::max<usz>(stats.lookups, 1));
+    }
+
+    std::printf("\n%9s %14s\n", "unknowns", "ns per unknown");
+    for (usz unknowns : {1'000, 10'000, 100'000, 1'000'000}) {
+        Ast ast{};
+        Project project(ast);
+        TypeInference &inference = project.inference();
+
+        auto start = std::chrono::steady_clock::now();
+        Vec<TypeId> variables{};
+        for (usz i = 0; i < unknowns; i++) variables.push_back(inference.fresh(project));
+        for (usz i = 1; i < unknowns; i++) (void) inference.unify(variables[i - 1], variables[i], Span{}, project);
+        (void) inference.unify(variables.back(), INT_TYPE_ID, Span{}, project);
+
+        usz resolved = 0;
+        for (TypeId variable : variables) resolved += inference.resolve(variable, project) == INT_TYPE_ID;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (resolved != unknowns) std::fprintf(stderr, "warning: only %lu of %lu unknowns resolved\n", resolved, unknowns);
+        std::printf("%9lu %14.1f\n", unknowns, seconds * 1e9 / unknowns);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+// Measures parsing deeply nested indentation blocks: functions declared in
+// the bodies of functions, innermost holding an `unsafe` block, for growing
+// nesting depths. Every level is one call to `Parser::block`, so this is
+// mostly the cost of the block combinator and the calls it makes per element.
+//
+//     parser_bench [blocks]
+
+#include "Ast.hpp"
+#include "Common.hpp"
+#include "Parser.hpp"
+#include "Tokenizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Nests of `depth` functions, repeated until there are about `blocks` blocks.
+static Str nested_source(usz depth, usz blocks) {
+    Str source{};
+    for (usz nest = 0; nest * (depth + 1) < blocks; nest++) {
+        for (usz level = 0; level < depth; level++) {
+            source.append(level * 4, ' ');
+            source += "fun f(int a int b) > int:\n";
+        }
+        source.append(depth * 4, ' ');
+        source += "return unsafe:\n";
+        for (usz i = 0; i < 3; i++) {
+            source.append(depth * 4 + 4, ' ');
+            source += "a == b\n";
+        }
+        for (usz level = depth; level-- > 0;) {
+            source.append(level * 4, ' ');
+            source += "return a\n";
+        }
+        source += "\n";
+    }
+    return source;
+}
+
+int main(int argc, char *argv[]) {
+    usz blocks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+
+    std::printf("%6s %8s %10s %14s\n", "depth", "blocks", "MB", "ns per block");
+    for (usz depth : {1, 4, 16, 64}) {
+        Str source = nested_source(depth, blocks);
+        usz parsed_blocks = source.size() / (source.find("\n\n") + 2) * (depth + 1);
+
+        double best = 1e9;
+        for (usz round = 0; round < 5; round++) {
+            Tokenizer tokenizer(0, source);
+            Ast ast{};
+            Parser parser(tokenizer, ast);
+            auto start = std::chrono::steady_clock::now();
+            ErrorOr<Vec<ParsedStatement *>> stmts = parser.parse();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            if (not stmts.has_value()) {
+                std::fprintf(stderr, "error: %s\n", stmts.error().message.c_str());
+                return 1;
+            }
+        }
+        std::printf("%6lu %8lu %10.1f %14.1f\n", depth, parsed_blocks, source.size() / 1e6, best * 1e9 / parsed_blocks);
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Runs the compiler over generated corpora and compares it against a
+// baseline, failing when a phase got slower or the compiler needs more
+// memory than the baseline allows.
+//
+//     perf_gate <compiler> <baseline> [--bytes N] [--tolerance T] [--runs N] [--update]
+//
+// The baseline holds one measurement per line, `<corpus bytes> <metric>
+// <value>`, and `#` comments. The metrics are parse and check throughput in
+// MB/s, where higher is better, and peak RSS in MB, where lower is better.
+// Each is the best of `--runs` runs of `compiler --time-report --json`, and
+// may be worse than the baseline by the fraction `--tolerance` (0.25 by
+// default). The compiler must accept every corpus without diagnostics.
+// Without `--bytes`, every corpus size in the baseline is run.
+// `--update` writes the measurements into the baseline instead of checking.
+
+#include "Common.hpp"
+#include "Corpus.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+
+struct Measurement {
+    usz bytes;
+    Str metric;
+    double value;
+};
+
+static bool higher_is_better(StrView metric) { return metric.ends_with("_mb_per_s"); }
+
+static Vec<Measurement> read_baseline(const char *path) {
+    Vec<Measurement> baseline{};
+    std::ifstream file(path);
+    Str line{};
+    while (std::getline(file, line)) {
+        if (line.empty() or line.front() == '#') continue;
+        std::istringstream fields(line);
+        Measurement measurement{};
+        if (fields >> measurement.bytes >> measurement.metric >> measurement.value) baseline.push_back(measurement);
+    }
+    return baseline;
+}
+
+static bool write_baseline(const char *path, const Vec<Measurement> &baseline) {
+    std::ofstream file(path);
+    file << "# Written by `perf_gate <compiler> <baseline> --update`; see bench/PerfGate.cpp.\n";
+    file << "# corpus bytes, metric, value\n";
+    for (const Measurement &measurement : baseline)
+        file << measurement.bytes << ' ' << measurement.metric << ' ' << measurement.value << '\n';
+    return file.good();
+}
+
+// The number following `key` in `json`, starting the search at `from`.
+static Opt<double> number_after(const Str &json, StrView key, usz from = 0) {
+    usz position = json.find(key, from);
+    if (position == Str::npos) return std::nullopt;
+    return std::strtod(json.c_str() + position + key.size(), nullptr);
+}
+
+// Best-of-`runs` measurements of compiling `path`, or an error message.
+static ErrorOr<Vec<Measurement>> measure(const char *compiler, const Str &path, usz bytes, usz runs) {
+    double parse_seconds = 1e30, check_seconds = 1e30, peak_rss = 1e30;
+    Str report_path = path + ".json";
+    for (usz run = 0; run < runs; run++) {
+        Str command = "'" + Str(compiler) + "' --time-report --json '" + path + "' > /dev/null 2> '" + report_path + "'";
+        int status = std::system(command.c_str());
+        // Generated corpora are valid programs, so diagnostics mean the
+        // timings are of error paths rather than of the compiler's usual work.
+        if (status == -1 or not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+            return Error{"the compiler did not compile the corpus cleanly: " + command, Span{}};
+
+        std::ifstream file(report_path);
+        std::stringstream contents{};
+        contents << file.rdbuf();
+        Str json = contents.str();
+
+        Opt<double> parse = number_after(json, "\"seconds\": ", json.find("\"name\": \"parse\""));
+        Opt<double> check = number_after(json, "\"seconds\": ", json.find("\"name\": \"check\""));
+        usz last_phase = json.rfind("\"peak_rss_bytes\": ");
+        Opt<double> rss = last_phase == Str::npos ? std::nullopt : number_after(json, "\"peak_rss_bytes\": ", last_phase);
+        if (json.find("\"name\": \"check\"") == Str::npos or not parse.has_value() or not check.has_value() or
+            not rss.has_value())
+            return Error{"no phase report in " + report_path, Span{}};
+
+        parse_seconds = std::min(parse_seconds, parse.value());
+        check_seconds = std::min(check_seconds, check.value());
+        peak_rss = std::min(peak_rss, rss.value());
+    }
+    return Vec<Measurement>{
+            {bytes, "parse_mb_per_s", bytes / 1e6 / parse_seconds},
+            {bytes, "check_mb_per_s", bytes / 1e6 / check_seconds},
+            {bytes, "peak_rss_mb", peak_rss / 1e6},
+    };
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <compiler> <baseline> [--bytes N] [--tolerance T] [--runs N] [--update]\n",
+                     argv[0]);
+        return 1;
+    }
+    const char *compiler = argv[1], *baseline_path = argv[2];
+    Vec<usz> sizes{};
+    double tolerance = 0.25;
+    usz runs = 3;
+    bool update = false;
+    for (int i = 3; i < argc; i++) {
+        StrView arg = argv[i];
+        if (arg == "--bytes" and i + 1 < argc) sizes.push_back(std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--tolerance" and i + 1 < argc) tolerance = std::strtod(argv[++i], nullptr);
+        else if (arg == "--runs" and i + 1 < argc) runs = std::max<usz>(1, std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--update") update = true;
+    }
+
+    Vec<Measurement> baseline = read_baseline(baseline_path);
+    if (sizes.empty())
+        for (const Measurement &measurement : baseline)
+            if (std::find(sizes.begin(), sizes.end(), measurement.bytes) == sizes.end())
+                sizes.push_back(measurement.bytes);
+
+    usz regressions = 0;
+    for (usz bytes : sizes) {
+        Str path = "perf_corpus_" + std::to_string(bytes) + ".lav";
+        std::ofstream(path) << generate_corpus(CorpusOptions{}, bytes);
+
+        ErrorOr<Vec<Measurement>> measured = measure(compiler, path, bytes, runs);
+        if (not measured.has_value()) {
+            std::fprintf(stderr, "error: %s\n", measured.error().message.c_str());
+            return 1;
+        }
+
+        for (const Measurement &measurement : measured.value()) {
+            auto expected = std::find_if(baseline.begin(), baseline.end(), [&](const Measurement &entry) {
+                return entry.bytes == bytes and entry.metric == measurement.metric;
+            });
+            if (update) {
+                if (expected == baseline.end()) baseline.push_back(measurement);
+                else expected->value = measurement.value;
+                std::printf("%9lu %-16s %10.1f\n", bytes, measurement.metric.c_str(), measurement.value);
+                continue;
+            }
+            if (expected == baseline.end()) {
+                std::printf("%9lu %-16s %10.1f  (no baseline)\n", bytes, measurement.metric.c_str(), measurement.value);
+                continue;
+            }
+
+            bool regressed = higher_is_better(measurement.metric)
+                    ? measurement.value < expected->value * (1 - tolerance)
+                    : measurement.value > expected->value * (1 + tolerance);
+            regressions += regressed;
+            std::printf("%9lu %-16s %10.1f  baseline %10.1f  %s\n", bytes, measurement.metric.c_str(),
+                        measurement.value, expected->value, regressed ? "REGRESSED" : "ok");
+        }
+    }
+
+    if (update and not write_baseline(baseline_path, baseline)) {
+        std::fprintf(stderr, "error: could not write `%s`\n", baseline_path);
+        return 1;
+    }
+    return regressions > 0 ? 1 : 0;
+}
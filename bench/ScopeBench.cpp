@@ -0,0 +1,89 @@
+// Measures name lookups from the innermost of a chain of nested block scopes,
+// for a growing number of names in the outermost (namespace) scope.
+//
+//     scope_bench [lookups]
+//
+// "cold" binds a variable shadowing a looked-up name before each lookup, so
+// no cached resolution can be reused; "bind" binds a name nothing looked up,
+// which leaves them valid; "warm" repeats the same lookups without touching
+// the scopes.
+
+#include "Ast.hpp"
+#include "Common.hpp"
+#include "Interner.hpp"
+#include "Project.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+
+struct Result {
+    double cold_ns, bind_ns, warm_ns;
+};
+
+static Result measure(usz names, usz depth, usz lookups) {
+    Ast ast{};
+    Project project(ast);
+    ScopeId outer = project.create_scope(0);
+
+    Vec<Symbol> globals{};
+    for (usz i = 0; i < names; i++) {
+        Symbol name = interner.intern(std::format("global_{}", i));
+        globals.push_back(name);
+        (void) project.add_var_to_scope(outer, CheckedVariable{name, INT_TYPE_ID}, Span{});
+    }
+
+    ScopeId inner = outer;
+    for (usz level = 0; level < depth; level++) {
+        inner = project.create_scope(inner);
+        for (usz i = 0; i < 4; i++) {
+            Symbol name = interner.intern(std::format("local_{}_{}", level, i));
+            (void) project.add_var_to_scope(inner, CheckedVariable{name, INT_TYPE_ID}, Span{});
+        }
+    }
+    Symbol scratch_name = interner.intern("scratch");
+
+    // A fixed working set, as in a function body that keeps using the same names.
+    Vec<Symbol> queries{};
+    for (usz i = 0; i < 64; i++) queries.push_back(globals[(i * 7919) % names]);
+
+    usz found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (usz i = 0; i < lookups; i++) {
+        ScopeId scratch = project.create_scope(inner);
+        (void) project.add_var_to_scope(scratch, CheckedVariable{queries[(i + 1) % queries.size()], INT_TYPE_ID}, Span{});
+        found += project.find_var_in_scope(inner, queries[i % queries.size()]).has_value();
+    }
+    double cold = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (usz i = 0; i < lookups; i++) {
+        ScopeId scratch = project.create_scope(inner);
+        (void) project.add_var_to_scope(scratch, CheckedVariable{scratch_name, INT_TYPE_ID}, Span{});
+        found += project.find_var_in_scope(inner, queries[i % queries.size()]).has_value();
+    }
+    double bind = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (usz i = 0; i < lookups; i++) {
+        found += project.find_var_in_scope(inner, queries[i % queries.size()]).has_value();
+    }
+    double warm = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (found != lookups * 3) std::fprintf(stderr, "warning: only %lu of %lu lookups resolved\n", found, lookups * 3);
+    return Result{cold * 1e9 / lookups, bind * 1e9 / lookups, warm * 1e9 / lookups};
+}
+
+int main(int argc, char *argv[]) {
+    usz lookups = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200'000;
+
+    std::printf("%8s %6s %12s %12s %12s\n", "names", "depth", "cold ns", "bind ns", "warm ns");
+    for (usz names : {100, 1'000, 10'000}) {
+        for (usz depth : {1, 10, 50}) {
+            Result result = measure(names, depth, lookups);
+            std::printf("%8lu %6lu %12.1f %12.1f %12.1f\n", names, depth, result.cold_ns, result.bind_ns,
+                        result.warm_ns);
+        }
+    }
+    return 0;
+}
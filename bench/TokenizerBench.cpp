@@ -0,0 +1,108 @@
+// Measures tokenizer throughput with each scan kernel set the CPU supports,
+// plus the raw throughput of the line and identifier kernels on their own.
+//
+//     tokenizer_bench [file.lav] [iterations]
+//
+// Without a file, a synthetic ~64 MB Lavender program is generated.
+
+#include "Common.hpp"
+#include "Interner.hpp"
+#include "Scan.hpp"
+#include "Source.hpp"
+#include "Tokenizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+
+static Str synthetic_source(usz target_size) {
+    Str source{};
+    for (usz i = 0; source.size() < target_size; i++) {
+        source += std::format("// Object number {} with a reasonably long explanatory comment line\n", i);
+        source += std::format("object GeneratedRecordWithLongName{}[A]:\n", i);
+        source += std::format("    int counter_field_{} = 1_000_{}\n", i, 100 + i % 900);
+        source += std::format("    str description_{} = \"record {} says hello\\n and keeps talking\"\n", i, i);
+        source += std::format("    fun accessor_method_{}(A value) > A:\n", i);
+        source += "        return if value == value then value else value\n\n";
+    }
+    return source;
+}
+
+template <typename Fn> static double median_seconds(usz iterations, Fn fn) {
+    Vec<double> seconds{};
+    for (usz i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto end = std::chrono::steady_clock::now();
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+    std::sort(seconds.begin(), seconds.end());
+    return seconds[seconds.size() / 2];
+}
+
+int main(int argc, char *argv[]) {
+    Str buffer{};
+    StrView source{};
+    SourceMap sources{};
+    if (argc > 1) {
+        ErrorOr<FileId> file_id = sources.load(argv[1]);
+        if (not file_id.has_value()) {
+            std::fprintf(stderr, "error: %s\n", file_id.error().message.c_str());
+            return 1;
+        }
+        source = sources.file(file_id.value()).contents();
+    } else {
+        buffer = synthetic_source(64 * 1024 * 1024);
+        source = buffer;
+    }
+    usz iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+    Str identifiers{};
+    while (identifiers.size() < source.size()) {
+        identifiers.append(255, 'a');
+        identifiers.push_back(' ');
+    }
+
+    std::printf("input: %.1f MB, %lu iterations\n", source.size() / 1e6, iterations);
+
+    // Identifiers are interned as they are lexed; report the first pass
+    // before repeated runs push the hit rate towards 100%.
+    Tokenizer first_pass(0, source);
+    while (first_pass.next().type != Token::Type::Eof) {}
+    Interner::Stats stats = interner.stats();
+    std::printf("interner: %lu symbols, %lu lookups, %.1f%% hits, %.1f KB\n", stats.symbols, stats.lookups,
+                stats.hit_rate() * 100, stats.bytes / 1e3);
+    for (const auto &kernels : available_scan_kernels()) {
+        scan = kernels;
+
+        usz tokens = 0;
+        double tokenize_time = median_seconds(iterations, [&] {
+            Tokenizer tokenizer(0, source);
+            tokens = 0;
+            while (tokenizer.next().type != Token::Type::Eof) tokens++;
+        });
+
+        // Walk the input one line at a time, as comment skipping does.
+        usz lines = 0;
+        double line_time = median_seconds(iterations, [&] {
+            const char *end = source.data() + source.size();
+            lines = 0;
+            for (const char *p = source.data(); p < end; p = kernels.line(p, end) + 1) lines++;
+        });
+
+        // Identifier runs of 256 bytes separated by single spaces.
+        usz runs = 0;
+        double identifier_time = median_seconds(iterations, [&] {
+            const char *end = identifiers.data() + identifiers.size();
+            runs = 0;
+            for (const char *p = identifiers.data(); p < end; p = kernels.identifier(p, end) + 1) runs++;
+        });
+
+        std::printf("%-8s tokenize %7.3f GB/s %6.1f Mtokens/s | line %7.3f GB/s | identifier %7.3f GB/s\n",
+                    kernels.name, source.size() / tokenize_time / 1e9, tokens / tokenize_time / 1e6,
+                    source.size() / line_time / 1e9, identifiers.size() / identifier_time / 1e9);
+    }
+
+    return 0;
+}
@@ -1,99 +1,152 @@
+#include "Ast.hpp"
 #include "Common.hpp"
 #include "Checker.hpp"
+#include "Diagnostics.hpp"
+#include "Interner.hpp"
 #include "Parser.hpp"
+#include "Source.hpp"
+#include "Stats.hpp"
 #include "Token.hpp"
 #include "Tokenizer.hpp"
-#include <fstream>
+#include "Trace.hpp"
+#include <cstdlib>
 #include <iostream>
-#include <sstream>
-
-void display_error(const Error &, const Str &);
+#include <thread>
 
 int main(int argc, char *argv[]) {
-    if (argc < 2) {
-        return 1;
+    // lav [-j jobs] [--lazy-bodies] [--time-report] [--stats] [--json]
+    //     [--trace=out.json] file;
+    // `-j 0` uses every core. `--lazy-bodies` skips function and method
+    // bodies and parses each on the thread that first checks it, so syntax
+    // errors in bodies nothing checks go unreported; missing bodies and
+    // lexical errors still are. Reports go to stderr, as a table or with
+    // `--json` as JSON. The trace can be opened in chrome://tracing or
+    // Perfetto.
+    const char *path = nullptr;
+    const char *trace_path = nullptr;
+    usz jobs = 1;
+    bool lazy_bodies = false, time_report = false, print_stats = false, json = false;
+    for (int i = 1; i < argc; i++) {
+        StrView arg = argv[i];
+        if (arg == "-j" and i + 1 < argc) jobs = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg.starts_with("-j")) jobs = std::strtoul(argv[i] + 2, nullptr, 10);
+        else if (arg == "--lazy-bodies") lazy_bodies = true;
+        else if (arg == "--time-report") time_report = true;
+        else if (arg == "--stats") print_stats = true;
+        else if (arg == "--json") json = true;
+        else if (arg.starts_with("--trace=")) trace_path = argv[i] + 8;
+        else path = argv[i];
     }
-
-    auto filename = argv[1];
-    std::fstream file(filename);
-    if (!file.is_open()) {
-        std::cout << "error: could not open file `" << filename << "`\n";
+    if (path == nullptr) {
         return 1;
     }
-
-    std::stringstream ss;
-    ss << file.rdbuf();
-    auto source = ss.str();
-
-    Project project{};
-
-    auto tokenize_result = tokenize(filename, source);
-
-    for (auto &error : tokenize_result.errors) {
-        display_error(error, source);
+    if (jobs == 0) jobs = std::max(1u, std::thread::hardware_concurrency());
+
+    if (trace_path != nullptr) start_tracing();
+
+    Stats stats{};
+    auto finish = [&](int status) {
+        // Taken last, so they include names the checker lexed again.
+        Interner::Stats interner_stats = interner.stats();
+        stats.set("interner.symbols", interner_stats.symbols);
+        stats.set("interner.lookups", interner_stats.lookups);
+        stats.set("interner.bytes", interner_stats.bytes);
+        stats.set_rate("interner.hit_rate", interner_stats.hit_rate());
+        if (trace_path != nullptr) {
+            if (Opt<Error> error = write_trace(trace_path); error.has_value()) {
+                std::cout << "error: " << error.value().message << "\n";
+                status = 1;
+            }
+        }
+        if (json and (time_report or print_stats)) stats.print_json(std::cerr, time_report, print_stats);
+        else {
+            if (time_report) stats.print_phases(std::cerr);
+            if (print_stats) stats.print_counters(std::cerr);
+        }
+        return status;
+    };
+
+    SourceMap sources{};
+    ErrorOr<FileId> file_id = [&] {
+        PhaseTimer timer(stats, "load");
+        return sources.load(path);
+    }();
+    if (not file_id.has_value()) {
+        std::cout << "error: " << file_id.error().message << "\n";
+        return finish(1);
+    }
+    StrView source = sources.file(file_id.value()).contents();
+    stats.set("source_bytes", source.size());
+
+    Diagnostics diagnostics(sources);
+
+    Tokenizer tokenizer(file_id.value(), source);
+
+    // The AST lives until the end of the compilation.
+    Ast ast{};
+    Parser parser(tokenizer, ast, lazy_bodies);
+    // Tokens are produced as the parser asks for them, so tokenizing is
+    // timed as part of parsing.
+    ErrorOr<Vec<ParsedStatement *>> stmts = [&] {
+        PhaseTimer timer(stats, "parse");
+        ErrorOr<Vec<ParsedStatement *>> stmts = parser.parse();
+
+        // The parser only pulls as many tokens as it needs, so finish tokenizing
+        // after a syntax error; lexical errors are reported in preference to it.
+        if (not stmts.has_value())
+            while (tokenizer.next().type != Token::Type::Eof) {}
+        return stmts;
+    }();
+    sources.file(file_id.value()).set_line_starts(tokenizer.take_line_starts());
+
+    Ast::Stats ast_stats = ast.stats();
+    usz declarations = 0;
+    for (usz count : ast_stats.arena.counts) declarations += count;
+    stats.set("tokens", tokenizer.count());
+    stats.set("ast.expressions", ast_stats.expressions);
+    stats.set("ast.types", ast_stats.types);
+    stats.set("ast.declarations", declarations);
+    stats.set("ast.bytes", ast_stats.bytes + ast_stats.arena.reserved);
+
+    for (auto &error : tokenizer.errors()) {
+        diagnostics.error(error);
     }
-    if (!tokenize_result.errors.empty()) return 1;
-
-    auto tokens = normalize(tokenize_result.tokens);
-
-//    for (auto &token : tokens) {
-//        auto &span = token.span;
-//
-//        std::cout << "\033[1m" << span.filename << ":" << span.line << ":"
-//                  << span.column << ": \033[32mtoken: \033[0m"
-//                  << Token::type_to_string(token.type);
-//        switch (token.type) {
-//        case Token::Type::Id:
-//        case Token::Type::Int:
-//        case Token::Type::Float:
-//        case Token::Type::String:
-//            std::cout << " `" << token.value.value() << "`";
-//            break;
-//        default:
-//            break;
-//        }
-//        std::cout << "\n";
-//    }
-
-    Parser parser(tokens);
-    ErrorOr<Vec<ParsedStatement *>> stmts = parser.parse();
+    if (not tokenizer.errors().empty()) {
+        diagnostics.flush(std::cout);
+        return finish(1);
+    }
+
     if (not stmts.has_value()) {
-        Error error = stmts.error();
-        display_error(error, source);
-        return 1;
+        diagnostics.error(stmts.error());
+        diagnostics.flush(std::cout);
+        return finish(1);
     }
-    auto statements = stmts.value();
+    auto &statements = stmts.value();
 
-    AstPrinter printer{};
+    AstPrinter printer{ast};
 //    printer.print(statements);
 
-    auto *scope = new Scope(std::make_optional(0));
-    project.scopes.push_back(scope);
-    ScopeId scope_id = project.scopes.size() - 1;
+    Project project(ast, jobs);
+    Opt<Error> result = [&] {
+        PhaseTimer timer(stats, "check");
+        ScopeId scope_id = project.create_scope(0);
+        return typecheck_namespace(parser.parsed_namespace(), scope_id, project);
+    }();
+
+    Project::Stats project_stats = project.stats();
+    stats.set("project.types", project_stats.types);
+    stats.set("project.scopes", project_stats.scopes);
+    stats.set("project.functions", project_stats.functions);
+    stats.set("project.records", project_stats.records);
+    stats.set("project.checked_bytes", project_stats.checked_bytes);
+    stats.set("substitution.lookups", project_stats.substitutions.lookups);
+    stats.set("substitution.hits", project_stats.substitutions.hits);
 
-    Opt<Error> result = typecheck_namespace(parser.parsed_namespace(), scope_id, project);
     if (result.has_value()) {
-        Error error = result.value();
-        display_error(error, source);
-        return 1;
+        diagnostics.error(result.value());
+        diagnostics.flush(std::cout);
+        return finish(1);
     }
 
-    return 0;
+    return finish(0);
 }
-
-void display_error(const Error &error, const Str &source) {
-    auto &span = error.span;
-
-    std::cout << "\033[1;1m" << span.filename << ":" << span.line << ":"
-              << span.column << ": \033[31;1merror: \033[0m" << error.message
-              << "\n";
-
-    Vec<Str> lines = split(source, '\n');
-    Str line = lines[span.line - 1];
-
-    // TODO: highlight snippet using `tokenize(span.filename, source);`
-    usz length = std::to_string(span.line).size();
-    std::cout << "\033[36;1m " << span.line << " | \033[0m" << line << "\n";
-    std::cout << "\033[36;1m " << std::string(length, ' ') << " | \033[31;1m" << std::string(span.column - 1, ' ')
-              << '^' << std::string(span.length - 1, '~') << '\n';
-}
\ No newline at end of file
@@ -0,0 +1,15 @@
+# Compiles FILE as is and with `--lazy-bodies` on two threads, and fails
+# unless both print the same diagnostics and exit the same way.
+#
+#     cmake -DCOMPILER=<compiler> -DFILE=<file.lav> -P CompareLazyBodies.cmake
+
+execute_process(COMMAND ${COMPILER} ${FILE}
+        OUTPUT_VARIABLE eager_output RESULT_VARIABLE eager_status)
+execute_process(COMMAND ${COMPILER} -j 2 --lazy-bodies ${FILE}
+        OUTPUT_VARIABLE lazy_output RESULT_VARIABLE lazy_status)
+
+if (NOT eager_status STREQUAL lazy_status OR NOT eager_output STREQUAL lazy_output)
+    message(FATAL_ERROR "--lazy-bodies changes the result for ${FILE}\n"
+            "eager (exit ${eager_status}):\n${eager_output}\n"
+            "lazy (exit ${lazy_status}):\n${lazy_output}")
+endif ()